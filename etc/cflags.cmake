@@ -6,3 +6,10 @@ set(SANITIZING_FLAGS -fno-sanitize-recover=all -fsanitize=undefined -fsanitize=a
 # ask for more warnings from the compiler
 set (CMAKE_BASE_CXX_FLAGS "${CMAKE_CXX_FLAGS}")
 set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wall -Wpedantic -Wextra -Weffc++ -Werror -Wshadow -Wpointer-arith -Wcast-qual -Wformat=2 -Wno-unqualified-std-cast-call")
+
+# Buffers may be shared between threads (e.g. by ShardedStack), so their reference counts are atomic
+# unless the build promises to stay single-threaded
+option (MINNOW_SINGLE_THREADED "Use non-atomic reference counts in Buffer" OFF)
+if (MINNOW_SINGLE_THREADED)
+  add_compile_definitions (MINNOW_SINGLE_THREADED)
+endif ()
@@ -45,6 +45,9 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_delayed_ack)
+ttest(recv_autotune)
+ttest(recv_batch)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -55,8 +58,19 @@ ttest(send_close)
 ttest(send_extra)
 
 ttest(net_interface)
+ttest(net_interface_aqm)
+ttest(net_interface_qos)
 
 ttest(router)
+ttest(fib)
+
+ttest(connection_table)
+ttest(sharded_stack)
+ttest(tcp_segment)
+ttest(checksum)
+ttest(packet_buffer)
+ttest(buffer)
+ttest(pcap)
 
 add_custom_target (check0 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R 'webget|^byte_stream_')
 
@@ -90,3 +104,14 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(recv_speed_test)
+stest(connection_table_speed_test)
+stest(tcp_stack_speed_test)
+stest(fleet_speed_test)
+stest(sharded_stack_speed_test)
+stest(tcp_segment_speed_test)
+stest(checksum_speed_test)
+stest(header_parse_speed_test)
+stest(net_interface_speed_test)
+stest(pcap_replay_speed_test)
+stest(fib_speed_test)
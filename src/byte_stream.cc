@@ -6,11 +6,16 @@ using namespace std;
 
 /* ByteStream: */
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ), available_capacity_( capacity_ ) {}
+ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
 
 /* Writer: */
 
 void Writer::push( string data )
+{
+  push( Buffer { std::move( data ) } );
+}
+
+void Writer::push( Buffer data )
 {
   // 空数据
   if ( data.empty() ) {
@@ -36,15 +41,14 @@ void Writer::push( string data )
     const uint64_t len = data.size();
     const uint64_t write_len = len < available_capacity() ? len : available_capacity();
     if ( write_len < len ) {
-      data = data.substr( 0, write_len );
+      data = data.slice( 0, write_len );
       /* string err_msg = "No enough capacity, Write data : ";
       ( err_msg += to_string( write_len ) += '/' ) += to_string( len );
       cerr << err_msg << endl; */
     }
-    pipe_string_.push_back( std::move( data ) );
-    pipe_view_.emplace_back( pipe_string_.back() );
+    pipe_buffer_.push_back( std::move( data ) );
+    pipe_view_.emplace_back( static_cast<string_view>( pipe_buffer_.back() ) );
     total_pushed_ += write_len;
-    available_capacity_ -= write_len;
   }
 }
 
@@ -69,9 +73,20 @@ bool Writer::is_closed() const
   return closed_;
 }
 
+void Writer::set_capacity( uint64_t capacity )
+{
+  capacity_ = capacity;
+}
+
 uint64_t Writer::available_capacity() const
 {
-  return available_capacity_;
+  const uint64_t buffered = total_pushed_ - total_popped_;
+  return capacity_ > buffered ? capacity_ - buffered : 0;
+}
+
+uint64_t Writer::capacity() const
+{
+  return capacity_;
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -114,7 +129,7 @@ void Reader::pop( uint64_t len )
     if ( pop_len >= cur_pop_len ) {
       // pop当前view
       pipe_view_.pop_front();
-      pipe_string_.pop_front();
+      pipe_buffer_.pop_front();
       pop_len -= cur_pop_len;
     } else {
       cur_pop_len = pop_len;
@@ -122,7 +137,6 @@ void Reader::pop( uint64_t len )
       pop_len = 0;
     }
     total_popped_ += cur_pop_len;
-    available_capacity_ += cur_pop_len;
   }
 }
 
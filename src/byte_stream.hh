@@ -1,5 +1,7 @@
 #pragma once
 
+#include "buffer.hh"
+
 #include <deque>
 #include <stdexcept>
 #include <string>
@@ -13,7 +15,6 @@ class ByteStream
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
-  uint64_t available_capacity_;
   uint64_t total_pushed_ = 0;
   uint64_t total_popped_ = 0;
 
@@ -21,7 +22,7 @@ protected:
   bool has_error_ = false;
 
   std::string err_msg_ = {};
-  std::deque<std::string> pipe_string_ = {};
+  std::deque<Buffer> pipe_buffer_ = {}; // shared with the writer's Buffers, not copied
   std::deque<std::string_view> pipe_view_ = {};
 
 public:
@@ -38,12 +39,18 @@ class Writer : public ByteStream
 {
 public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
+  void push( Buffer data );      // The same, keeping a reference to `data` instead of copying it.
 
   void close();     // Signal that the stream has reached its ending. Nothing more will be written.
   void set_error(); // Signal that the stream suffered an error.
 
+  // Grow or shrink the stream's capacity. Shrinking below bytes already buffered keeps those bytes,
+  // but nothing more can be pushed until the reader has caught up.
+  void set_capacity( uint64_t capacity );
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
+  uint64_t capacity() const;           // Maximum number of bytes the stream may buffer
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
 };
 
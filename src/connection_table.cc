@@ -0,0 +1,37 @@
+#include "connection_table.hh"
+
+using namespace std;
+
+TCPConnection* ConnectionTable::find( const ConnectionKey& key )
+{
+  unique_ptr<TCPConnection>* conn = connections_.find( key );
+  return conn ? conn->get() : nullptr;
+}
+
+TCPConnection& ConnectionTable::open( const ConnectionKey& key, const TCPConfig& config )
+{
+  if ( TCPConnection* conn = find( key ) )
+    return *conn;
+  return **connections_.insert( key, make_unique<TCPConnection>( config ) ).first;
+}
+
+bool ConnectionTable::close( const ConnectionKey& key )
+{
+  return connections_.erase( key );
+}
+
+bool ConnectionTable::demux( const ConnectionKey& key, TCPMessage message )
+{
+  TCPConnection* conn = find( key );
+  if ( !conn )
+    return false;
+  conn->receive( std::move( message ) );
+  return true;
+}
+
+void ConnectionTable::tick( const uint64_t ms_since_last_tick )
+{
+  connections_.for_each( [ms_since_last_tick]( const ConnectionKey&, unique_ptr<TCPConnection>& conn ) {
+    conn->tick( ms_since_last_tick );
+  } );
+}
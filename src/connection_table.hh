@@ -0,0 +1,72 @@
+#pragma once
+
+#include "flat_hash_map.hh"
+#include "tcp_connection.hh"
+
+#include <cstdint>
+#include <memory>
+
+// The 4-tuple that identifies a TCP connection (from the point of view of the local host)
+struct ConnectionKey
+{
+  uint32_t src_ip {};
+  uint32_t dst_ip {};
+  uint16_t src_port {};
+  uint16_t dst_port {};
+
+  bool operator==( const ConnectionKey& other ) const = default;
+};
+
+struct ConnectionKeyHash
+{
+  size_t operator()( const ConnectionKey& key ) const
+  {
+    // splitmix64 finalizer over the packed 4-tuple
+    const uint64_t addrs = static_cast<uint64_t>( key.src_ip ) << 32 | key.dst_ip;
+    const uint64_t ports = static_cast<uint64_t>( key.src_port ) << 16 | key.dst_port;
+    uint64_t x = addrs ^ ( ports * 0x9e3779b97f4a7c15ULL );
+    x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+    x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111ebULL;
+    return x ^ ( x >> 31 );
+  }
+};
+
+// A table of TCP connections, keyed by 4-tuple, used to demultiplex incoming segments.
+//
+// Lookups probe one flat open-addressing array. The connections themselves are heap-allocated, so
+// a TCPConnection& stays valid while other connections are added or removed.
+class ConnectionTable
+{
+private:
+  FlatHashMap<ConnectionKey, std::unique_ptr<TCPConnection>, ConnectionKeyHash> connections_;
+
+public:
+  explicit ConnectionTable( size_t expected_connections = 16 ) : connections_( expected_connections ) {}
+
+  // Find the connection for a 4-tuple (or nullptr if there is none)
+  TCPConnection* find( const ConnectionKey& key );
+
+  // Find the connection for a 4-tuple, creating it with `config` if it does not exist yet
+  TCPConnection& open( const ConnectionKey& key, const TCPConfig& config );
+
+  // Remove a connection. Returns false if there was no such connection.
+  bool close( const ConnectionKey& key );
+
+  // Deliver an incoming segment to its connection. Returns false (and drops the segment) if there
+  // is no connection for the 4-tuple.
+  bool demux( const ConnectionKey& key, TCPMessage message );
+
+  // Advance time on every connection
+  void tick( uint64_t ms_since_last_tick );
+
+  // Call `f( key, connection )` for every connection
+  template<typename F>
+  void for_each( F&& f )
+  {
+    connections_.for_each( [&f]( const ConnectionKey& key, std::unique_ptr<TCPConnection>& conn ) {
+      f( key, *conn );
+    } );
+  }
+
+  size_t size() const { return connections_.size(); }
+};
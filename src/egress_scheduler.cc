@@ -0,0 +1,141 @@
+#include "egress_scheduler.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+void EgressScheduler::set_config( const EgressConfig& config )
+{
+  if ( config.classes.empty() ) {
+    throw invalid_argument( "EgressScheduler: at least one traffic class is required" );
+  }
+  for ( const auto& traffic_class : config.classes ) {
+    if ( !traffic_class.strict && traffic_class.quantum == 0 ) {
+      throw invalid_argument( "EgressScheduler: a round-robin class needs a nonzero quantum" );
+    }
+  }
+  for ( const auto index : config.dscp_class ) {
+    if ( index >= config.classes.size() ) {
+      throw invalid_argument( "EgressScheduler: a DSCP value maps to missing class " + to_string( index ) );
+    }
+  }
+
+  // 保留已有类的队列 (和里面的帧), 多出来的类丢弃
+  if ( classes_.size() > config.classes.size() ) {
+    classes_.erase( classes_.begin() + static_cast<ptrdiff_t>( config.classes.size() ), classes_.end() );
+  }
+  for ( size_t i = 0; i < config.classes.size(); i++ ) {
+    if ( i < classes_.size() ) {
+      classes_[i].config = config.classes[i];
+      classes_[i].queue.set_config( config.classes[i].queue );
+    } else {
+      classes_.push_back( { config.classes[i], TransmitQueue { config.classes[i].queue } } );
+    }
+  }
+  dscp_class_ = config.dscp_class;
+
+  // 重新开始一轮
+  round_robin_.clear();
+  quantum_added_ = false;
+  for ( size_t i = 0; i < classes_.size(); i++ ) {
+    Class& c = classes_[i];
+    c.deficit = 0;
+    c.active = !c.config.strict && !c.queue.empty();
+    if ( c.active ) {
+      round_robin_.push_back( i );
+    }
+  }
+}
+
+void EgressScheduler::set_queue_config( const TransmitQueueConfig& config )
+{
+  for ( auto& c : classes_ ) {
+    c.config.queue = config;
+    c.queue.set_config( config );
+  }
+}
+
+void EgressScheduler::push( OutgoingFrame frame, const uint8_t tos, const uint64_t now_ms )
+{
+  const size_t index = classify( tos );
+  Class& c = classes_[index];
+  c.queue.push( std::move( frame ), now_ms );
+  if ( !c.config.strict && !c.active && !c.queue.empty() ) {
+    c.active = true;
+    round_robin_.push_back( index );
+  }
+}
+
+optional<OutgoingFrame> EgressScheduler::pop( const uint64_t now_ms )
+{
+  // 严格优先级的类先发 (CoDel 可能把队列丢空, 这时 pop 返回空)
+  for ( auto& c : classes_ ) {
+    if ( c.config.strict && !c.queue.empty() ) {
+      if ( auto frame = c.queue.pop( now_ms ) ) {
+        return frame;
+      }
+    }
+  }
+  return pop_round_robin( now_ms );
+}
+
+optional<OutgoingFrame> EgressScheduler::pop_round_robin( const uint64_t now_ms )
+{
+  while ( !round_robin_.empty() ) {
+    const size_t index = round_robin_.front();
+    Class& c = classes_[index];
+    if ( c.queue.empty() ) {
+      // 队列空了就离开轮转, 赤字不能攒到下次
+      c.active = false;
+      c.deficit = 0;
+      round_robin_.pop_front();
+      quantum_added_ = false;
+      continue;
+    }
+
+    if ( !quantum_added_ ) {
+      c.deficit += c.config.quantum;
+      quantum_added_ = true;
+    }
+    if ( c.queue.front_bytes() > c.deficit ) {
+      // 这一轮的额度用完了, 轮到下一个类
+      round_robin_.pop_front();
+      round_robin_.push_back( index );
+      quantum_added_ = false;
+      continue;
+    }
+
+    // CoDel 可能丢掉队头, 发出的是后面的帧 (或者什么都不发), 按实际发出的帧扣赤字
+    optional<OutgoingFrame> frame = c.queue.pop( now_ms );
+    if ( frame ) {
+      c.deficit -= min( c.deficit, frame->wire.size() );
+    }
+    if ( c.queue.empty() ) {
+      c.active = false;
+      c.deficit = 0;
+      round_robin_.pop_front();
+      quantum_added_ = false;
+    }
+    if ( frame ) {
+      return frame;
+    }
+  }
+  return {};
+}
+
+TransmitQueue::Stats EgressScheduler::stats() const
+{
+  TransmitQueue::Stats total;
+  for ( const auto& c : classes_ ) {
+    const TransmitQueue::Stats& s = c.queue.stats();
+    total.enqueued += s.enqueued;
+    total.dequeued += s.dequeued;
+    total.tail_drops += s.tail_drops;
+    total.early_drops += s.early_drops;
+    total.codel_drops += s.codel_drops;
+    total.total_delay_ms += s.total_delay_ms;
+    total.max_delay_ms = max( total.max_delay_ms, s.max_delay_ms );
+  }
+  return total;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "transmit_queue.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+// One class of outgoing traffic, with a queue of its own
+struct TrafficClass
+{
+  bool strict = false;          // served ahead of every non-strict class (strict classes in order of index)
+  size_t quantum = 1514;        // bytes a non-strict class may send per deficit-round-robin round (its weight)
+  TransmitQueueConfig queue {}; // discipline and limit of the class's queue
+};
+
+// Config for an EgressScheduler
+struct EgressConfig
+{
+  static constexpr size_t DSCP_VALUES = 64;
+
+  std::vector<TrafficClass> classes { TrafficClass {} };
+  std::array<uint8_t, DSCP_VALUES> dscp_class {}; // class of each DSCP value (the top six bits of the TOS byte)
+};
+
+// Outgoing frames, classified by DSCP into several queues.
+//
+// Strict-priority classes are always served first, in order. The remaining classes share what is left by
+// deficit round robin (Shreedhar & Varghese 1995): each visit to a backlogged class adds its quantum to
+// the class's deficit, and the class sends frames while their size fits within the deficit. Over time each
+// class gets link bytes in proportion to its quantum, whatever the sizes of its frames.
+class EgressScheduler
+{
+  struct Class
+  {
+    TrafficClass config;
+    TransmitQueue queue;
+    size_t deficit {};
+    bool active {}; // is the class in the round-robin list?
+  };
+
+  std::vector<Class> classes_ {};
+  std::array<uint8_t, EgressConfig::DSCP_VALUES> dscp_class_ {};
+  std::deque<size_t> round_robin_ {}; // backlogged non-strict classes, the one being served first
+  bool quantum_added_ {};             // has the class at the front had its quantum this round?
+
+  std::optional<OutgoingFrame> pop_round_robin( uint64_t now_ms );
+
+public:
+  explicit EgressScheduler( const EgressConfig& config = {} ) { set_config( config ); }
+
+  // Change the classes (frames already queued stay in the queue of the class with the same index, if any).
+  // Throws std::invalid_argument if there are no classes, or if a DSCP value maps to a missing class.
+  void set_config( const EgressConfig& config );
+
+  // Apply one queue configuration to every class
+  void set_queue_config( const TransmitQueueConfig& config );
+
+  // Which class does a datagram with this TOS byte belong to?
+  size_t classify( uint8_t tos ) const { return dscp_class_[tos >> 2]; }
+
+  void push( OutgoingFrame frame, uint8_t tos, uint64_t now_ms );
+  std::optional<OutgoingFrame> pop( uint64_t now_ms );
+
+  size_t num_classes() const { return classes_.size(); }
+  const TransmitQueue::Stats& stats( size_t traffic_class ) const
+  {
+    return classes_.at( traffic_class ).queue.stats();
+  }
+
+  // Totals over every class (the maximum delay is the largest of any class)
+  TransmitQueue::Stats stats() const;
+};
@@ -0,0 +1,98 @@
+#include "fib.hh"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// 把前缀覆盖的表项中, 不属于更长前缀的那些指向新的下一跳
+void cover( uint16_t* hops, uint8_t* depths, const size_t count, const uint8_t length, const uint16_t next_hop )
+{
+  for ( size_t i = 0; i < count; i++ ) {
+    if ( depths[i] <= length ) {
+      hops[i] = next_hop;
+      depths[i] = length;
+    }
+  }
+}
+
+} // namespace
+
+void Fib::insert( const uint32_t prefix, const uint8_t length, const uint16_t next_hop )
+{
+  if ( length > 32 ) {
+    throw invalid_argument( "Fib: prefix length " + to_string( length ) + " is longer than 32" );
+  }
+  if ( next_hop == NO_ROUTE or next_hop > MAX_NEXT_HOP ) {
+    throw invalid_argument( "Fib: next hop " + to_string( next_hop ) + " is out of range" );
+  }
+
+  // 只保留前缀部分, 主机位不参与匹配
+  const uint32_t masked = length == 0 ? 0 : prefix & ~( ( uint64_t { 1 } << ( 32 - length ) ) - 1 );
+  const Route route { masked, length, next_hop };
+
+  // 表已经建好了就只更新这个前缀覆盖的表项, 不用整表重建
+  if ( not tbl24_.empty() and not stale_ ) {
+    apply( route );
+  } else {
+    stale_ = true;
+  }
+
+  const uint64_t key = static_cast<uint64_t>( masked ) << 8 | length;
+  if ( const auto it = route_index_.find( key ); it != route_index_.end() ) {
+    routes_[it->second].next_hop = next_hop;
+  } else {
+    route_index_.emplace( key, routes_.size() );
+    routes_.push_back( route );
+  }
+}
+
+void Fib::build()
+{
+  if ( not stale_ ) {
+    return;
+  }
+
+  tbl24_.assign( size_t { 1 } << 24, NO_ROUTE );
+  depth24_.assign( tbl24_.size(), 0 );
+  tbl8_.clear();
+  depth8_.clear();
+  for ( const auto& route : routes_ ) {
+    apply( route );
+  }
+  stale_ = false;
+}
+
+void Fib::apply( const Route& route )
+{
+  if ( route.length <= 24 ) {
+    const size_t first = route.prefix >> 8;
+    const size_t count = size_t { 1 } << ( 24 - route.length );
+    for ( size_t i = first; i < first + count; i++ ) {
+      if ( tbl24_[i] & TBL8_FLAG ) {
+        // 这个 /24 里有更长的前缀, 更新它的 tbl8 组
+        const size_t group = static_cast<size_t>( tbl24_[i] & ~TBL8_FLAG ) << 8;
+        cover( &tbl8_[group], &depth8_[group], 256, route.length, route.next_hop );
+      } else {
+        cover( &tbl24_[i], &depth24_[i], 1, route.length, route.next_hop );
+      }
+    }
+    return;
+  }
+
+  // 比 /24 长的前缀: 这个 /24 需要一个 tbl8 组, 先用它原来的下一跳填满
+  const size_t index = route.prefix >> 8;
+  if ( not( tbl24_[index] & TBL8_FLAG ) ) {
+    if ( tbl8_groups() == TBL8_FLAG ) {
+      throw length_error( "Fib: too many /24s with prefixes longer than /24" );
+    }
+    tbl8_.resize( tbl8_.size() + 256, tbl24_[index] );
+    depth8_.resize( depth8_.size() + 256, depth24_[index] );
+    tbl24_[index] = static_cast<uint16_t>( TBL8_FLAG | ( tbl8_groups() - 1 ) );
+  }
+  const size_t group = static_cast<size_t>( tbl24_[index] & ~TBL8_FLAG ) << 8;
+  const size_t first = group | ( route.prefix & 0xff );
+  cover( &tbl8_[first], &depth8_[first], size_t { 1 } << ( 32 - route.length ), route.length, route.next_hop );
+}
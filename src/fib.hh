@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// A forwarding table: longest-prefix match from IPv4 addresses to small next-hop indices.
+//
+// Lookups use DIR-24-8 (Gupta, Lin & McKeown 1998). tbl24 has an entry for every /24, holding either the
+// next hop of the longest prefix of length <= 24 that covers it, or (for /24s that have longer prefixes in
+// them) the index of a 256-entry tbl8 group, one entry per address. A lookup is one or two memory reads.
+//
+// Until the first build(), insert() only records the route, so load a table by adding a batch of routes
+// and then building once. After that, insert() updates the tables in place, touching only the entries the
+// new prefix covers. Each entry remembers the length of the prefix that set it, so a route only replaces
+// matches that are no longer than itself.
+class Fib
+{
+public:
+  static constexpr uint16_t NO_ROUTE = 0;
+  static constexpr uint16_t MAX_NEXT_HOP = 0x7fff;
+
+private:
+  static constexpr uint16_t TBL8_FLAG = 0x8000; // the rest of a tbl24 entry with this bit is a tbl8 group
+
+  struct Route
+  {
+    uint32_t prefix;
+    uint8_t length;
+    uint16_t next_hop;
+  };
+
+  std::vector<Route> routes_ {};
+  std::unordered_map<uint64_t, size_t> route_index_ {}; // (prefix, length) => index in routes_
+  std::vector<uint16_t> tbl24_ {};                      // empty until the first build
+  std::vector<uint16_t> tbl8_ {};
+  std::vector<uint8_t> depth24_ {}; // length of the prefix behind each tbl24 entry (0 for none)
+  std::vector<uint8_t> depth8_ {};  // and each tbl8 entry
+  bool stale_ {};
+
+  // Point the entries `route` covers at its next hop, except those set by longer prefixes
+  void apply( const Route& route );
+
+public:
+  // Route addresses matching the top `length` bits of `prefix` to `next_hop` (1 to MAX_NEXT_HOP). The other
+  // bits of `prefix` are ignored. A second route for the same prefix replaces the first.
+  // Throws std::invalid_argument for a bad length or next hop, and (once the tables are built)
+  // std::length_error if the route would need a tbl8 group and all are in use.
+  void insert( uint32_t prefix, uint8_t length, uint16_t next_hop );
+
+  // Build the tables from the routes inserted so far (does nothing once they are built).
+  // Throws std::length_error if more than 32768 /24s hold prefixes longer than /24.
+  void build();
+
+  // Next hop of the longest prefix matching `address`, or NO_ROUTE (always NO_ROUTE before the first build)
+  uint16_t lookup( const uint32_t address ) const
+  {
+    if ( tbl24_.empty() ) {
+      return NO_ROUTE;
+    }
+    const uint16_t entry = tbl24_[address >> 8];
+    if ( entry & TBL8_FLAG ) {
+      return tbl8_[static_cast<size_t>( entry & ~TBL8_FLAG ) << 8 | ( address & 0xff )];
+    }
+    return entry;
+  }
+
+  size_t size() const { return routes_.size(); }
+  size_t tbl8_groups() const { return tbl8_.size() >> 8; }
+};
@@ -2,19 +2,42 @@
 
 #include "arp_message.hh"
 #include "ethernet_frame.hh"
+#include "packet_buffer.hh"
 using namespace std;
 
+namespace {
+
+// 把以太网帧组装成一个连续的 Buffer: IPv4 头部和以太网头部依次 prepend 到预留的 headroom 里,
+// 以太网头部只是从邻居的头部模板拷贝 14 个字节
+OutgoingFrame encapsulate( const InternetDatagram& dgram,
+                           const EthernetHeader& header,
+                           const array<char, EthernetHeader::LENGTH>& header_bytes )
+{
+  size_t payload_size = 0;
+  for ( const auto& x : dgram.payload ) {
+    payload_size += x.size();
+  }
+  PacketBuffer packet { EthernetHeader::LENGTH + dgram.header.serialized_length(), payload_size };
+  packet.append( dgram.payload );
+  packet.push_header( dgram.header );
+  memcpy( packet.prepend( EthernetHeader::LENGTH ).data(), header_bytes.data(), header_bytes.size() );
+
+  OutgoingFrame out;
+  out.frame.header = header;
+  out.wire = packet.release();
+  out.frame.payload = { out.wire.slice( EthernetHeader::LENGTH ) };
+  return out;
+}
+
+} // namespace
+
 // ethernet_address: Ethernet (what ARP calls "hardware") address of the interface
 // ip_address: IP (what ARP calls "protocol") address of the interface
 NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address )
   : ethernet_address_( ethernet_address )
   , ip_address_( ip_address )
   , ip_to_send_()
-  , frame_to_fill_()
   , arp_to_send_()
-  , arp_time()
-  , ip_mac()
-  , ip_time()
 {
   cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address_ ) << " and IP address "
        << ip_address.ip() << "\n";
@@ -29,23 +52,33 @@ NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, con
 void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Address& next_hop )
 {
   const uint32_t& next_ip = next_hop.ipv4_numeric();
-  if ( ip_mac.find( next_ip ) == ip_mac.end() ) {
-    if ( arp_time.find( next_ip ) == arp_time.end() )
-      broadcastARP( next_ip );
-    EthernetFrame need_be_filled;
-    need_be_filled.header.src = ethernet_address_;
-    need_be_filled.header.type = EthernetHeader::TYPE_IPv4;
-    need_be_filled.payload = serialize( dgram );
-    frame_to_fill_.push( std::move( need_be_filled ) );
+  ArpEntry* mapping = ip_mac_.find( next_ip );
+  if ( mapping == nullptr ) {
+    if ( arp_requests_.find( next_ip ) == nullptr ) {
+      if ( !admitARPRequest( next_ip ) )
+        return; // 不发ARP请求, 数据报也不排队
+      sendARPRequest( next_ip );
+    }
+    auto& pending = pending_frames_[next_ip];
+    if ( pending.size() >= MAX_PENDING_PER_HOP ) {
+      ++pending_dropped_; // 等待ARP的队列已满, 丢弃
+      return;
+    }
+    // 目的地址还不知道, 以太网头部先空着, 收到ARP回复时再填
+    const EthernetHeader need_be_filled { {}, ethernet_address_, EthernetHeader::TYPE_IPv4 };
+    pending.push( { encapsulate( dgram, need_be_filled, {} ), dgram.header.tos } );
     return;
   }
+  // 映射快要过期而且仍在使用: 继续用旧的映射发送, 同时单播ARP请求刷新它
+  if ( !mapping->refreshing && mapping->expires_at_ms <= now_ms_ + ARP_REFRESH_WINDOW_MS ) {
+    mapping->refreshing = true;
+    sendARPRequest( next_ip, mapping->ethernet_address );
+    ++arp_refreshes_;
+  }
+
   // encasulate to frame_ip
-  EthernetFrame frame_ip;
-  frame_ip.header.src = ethernet_address_;
-  frame_ip.header.dst = ip_mac[next_ip];
-  frame_ip.header.type = EthernetHeader::TYPE_IPv4;
-  frame_ip.payload = serialize( dgram );
-  ip_to_send_.push( std::move( frame_ip ) );
+  const EthernetHeader header { mapping->ethernet_address, ethernet_address_, EthernetHeader::TYPE_IPv4 };
+  ip_to_send_.push( encapsulate( dgram, header, mapping->header_template ), dgram.header.tos, now_ms_ );
 }
 
 // frame: the incoming Ethernet frame
@@ -58,7 +91,9 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
   // 接收IP数据报
   if ( frame.header.type == EthernetHeader::TYPE_IPv4 ) {
     InternetDatagram ip_datagram;
-    if ( parse( ip_datagram, frame.payload ) )
+    Parser parser { frame.payload, not checksum_offload_ };
+    ip_datagram.parse( parser );
+    if ( not parser.has_error() )
       return ip_datagram;
   }
   // 接收ARP
@@ -66,7 +101,8 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
     ARPMessage arp_msg;
     parse( arp_msg, frame.payload );
     // 更新ARP表
-    updateARPTable( arp_msg.sender_ip_address, arp_msg.sender_ethernet_address );
+    updateARPTable(
+      arp_msg.sender_ip_address, arp_msg.sender_ethernet_address, arp_msg.opcode == ARPMessage::OPCODE_REPLY );
 
     // 回应arp_request信息
     if ( arp_msg.opcode == ARPMessage::OPCODE_REQUEST ) {
@@ -86,12 +122,6 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
       frame_arp_reply.header.type = EthernetHeader::TYPE_ARP;
       frame_arp_reply.payload = serialize( arp_reply );
       arp_to_send_.push( std::move( frame_arp_reply ) );
-    } else if ( arp_msg.opcode == ARPMessage::OPCODE_REPLY ) {
-      // 填充发出arp请求的mac帧
-      auto frame_valid = frame_to_fill_.front();
-      frame_valid.header.dst = arp_msg.sender_ethernet_address;
-      ip_to_send_.push( std::move( frame_valid ) );
-      frame_to_fill_.pop();
     }
   }
   return {}; // 不发送IP数据报
@@ -100,77 +130,205 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
 // ms_since_last_tick: the number of milliseconds since the last call to this method
 void NetworkInterface::tick( const size_t ms_since_last_tick )
 {
-  updateMappingTime( ms_since_last_tick );
-  updateArpTime( ms_since_last_tick );
+  now_ms_ += ms_since_last_tick;
+  expireMappings();
+  expireArpRequests();
+  expireArpFailures();
 }
 
 optional<EthernetFrame> NetworkInterface::maybe_send()
 {
   optional<EthernetFrame> maybe_send;
   if ( !arp_to_send_.empty() ) {
-    maybe_send = arp_to_send_.front();
+    maybe_send = std::move( arp_to_send_.front() );
     arp_to_send_.pop(); // lab不用考虑收不到的情况
-    ARPMessage arp_msg;
-    parse( arp_msg, maybe_send.value().payload );
-    arp_time.insert( { arp_msg.target_ip_address, 0 } );
-  } else if ( !ip_to_send_.empty() ) {
-    maybe_send = ip_to_send_.front();
-    ip_to_send_.pop();
+    if ( capture_ ) {
+      capture_( serialize( maybe_send.value() ), now_ms_ );
+    }
+  } else if ( auto next = ip_to_send_.pop( now_ms_ ) ) {
+    if ( capture_ ) {
+      capture_( { &next->wire, 1 }, now_ms_ );
+    }
+    maybe_send = std::move( next->frame );
   }
   return maybe_send;
 }
 
-void NetworkInterface::updateMappingTime( const size_t ms_since_last_tick )
+optional<Buffer> NetworkInterface::maybe_send_serialized()
+{
+  if ( !arp_to_send_.empty() ) {
+    // ARP帧很少, 临时拼接成一个 Buffer
+    string bytes;
+    for ( const auto& b : serialize( arp_to_send_.front() ) ) {
+      bytes.append( b );
+    }
+    arp_to_send_.pop();
+    Buffer wire { std::move( bytes ) };
+    if ( capture_ ) {
+      capture_( { &wire, 1 }, now_ms_ );
+    }
+    return wire;
+  }
+  // IPv4帧入队时已经组装好了
+  if ( auto next = ip_to_send_.pop( now_ms_ ) ) {
+    if ( capture_ ) {
+      capture_( { &next->wire, 1 }, now_ms_ );
+    }
+    return std::move( next->wire );
+  }
+  return {};
+}
+
+void NetworkInterface::set_capture( PcapWriter& writer )
+{
+  // 接口的时钟是毫秒, pcap 里记的是纳秒
+  capture_ = [&writer]( span<const Buffer> frame, uint64_t now_ms ) {
+    writer.write( frame, now_ms * 1'000'000 );
+  };
+}
+
+// 只处理已经到期的映射, 不扫描整个表
+void NetworkInterface::expireMappings()
 {
-  // update mapping table
-  auto it = ip_time.begin();
-  while ( it != ip_time.end() ) {
-    it->second += ms_since_last_tick;
-    if ( it->second >= 30000 ) {
-      ip_mac.erase( it->first );
-      it = ip_time.erase( it );
-    } else
-      ++it;
+  while ( !mapping_expiry_.empty() && mapping_expiry_.top().first <= now_ms_ ) {
+    const auto [expires_at_ms, ip] = mapping_expiry_.top();
+    mapping_expiry_.pop();
+    const ArpEntry* mapping = ip_mac_.find( ip );
+    if ( mapping && mapping->expires_at_ms == expires_at_ms ) // 否则映射已经被刷新过
+      ip_mac_.erase( ip );
+  }
+}
+
+void NetworkInterface::expireArpRequests()
+{
+  while ( !request_expiry_.empty() && request_expiry_.top().first <= now_ms_ ) {
+    const uint32_t ip = request_expiry_.top().second;
+    request_expiry_.pop();
+    arp_requests_.erase( ip );
+    if ( ip_mac_.find( ip ) == nullptr ) // 没有收到回复
+      recordArpFailure( ip );
+
+    // ARP请求超时, 丢弃等待这个地址的帧
+    const auto pending = pending_frames_.find( ip );
+    if ( pending != pending_frames_.end() ) {
+      pending_expired_ += pending->second.size();
+      pending_frames_.erase( pending );
+    }
   }
 }
 
-void NetworkInterface::updateArpTime( const size_t ms_since_last_tick )
+void NetworkInterface::expireArpFailures()
 {
-  auto it = arp_time.begin();
-  while ( it != arp_time.end() ) {
-    it->second += ms_since_last_tick;
-    if ( it->second >= 5000 )
-      it = arp_time.erase( it );
-    else
-      ++it;
+  while ( !failure_expiry_.empty() && failure_expiry_.top().first <= now_ms_ ) {
+    const auto [forget_at_ms, ip] = failure_expiry_.top();
+    failure_expiry_.pop();
+    const ArpFailure* failure = arp_failures_.find( ip );
+    if ( failure && failure->forget_at_ms == forget_at_ms ) // 否则之后又失败过
+      arp_failures_.erase( ip );
   }
 }
 
-void NetworkInterface::broadcastARP( uint32_t dst_ip )
+// 连续失败两次以后退避: 5 s, 10 s, 20 s, ... 最多一分钟
+void NetworkInterface::recordArpFailure( uint32_t ip )
 {
-  // 广播ARP request
+  ArpFailure* failure = arp_failures_.insert( ip, {} ).first;
+  ++failure->count;
+  failure->retry_at_ms = now_ms_;
+  if ( failure->count >= 2 ) {
+    const uint64_t backoff = ARP_REQUEST_TIMEOUT_MS << min<uint32_t>( failure->count - 2, 16 );
+    failure->retry_at_ms += min( backoff, ARP_BACKOFF_MAX_MS );
+  }
+  failure->forget_at_ms = failure->retry_at_ms + ARP_FAILURE_MEMORY_MS;
+  failure_expiry_.emplace( failure->forget_at_ms, ip );
+}
+
+// 能不能为 ip 广播一个新的ARP请求? 不能的话数据报被丢弃并计数
+bool NetworkInterface::admitARPRequest( uint32_t ip )
+{
+  const ArpFailure* failure = arp_failures_.find( ip );
+  if ( failure && now_ms_ < failure->retry_at_ms ) {
+    ++unreachable_dropped_;
+    return false;
+  }
+
+  // 令牌桶: 每 ARP_REQUEST_INTERVAL_MS 补充一个令牌, 最多 ARP_REQUEST_BURST 个
+  const uint64_t earned = ( now_ms_ - arp_tokens_updated_ms_ ) / ARP_REQUEST_INTERVAL_MS;
+  arp_tokens_ = min( arp_tokens_ + earned, ARP_REQUEST_BURST );
+  arp_tokens_updated_ms_ += earned * ARP_REQUEST_INTERVAL_MS;
+  if ( arp_tokens_ == ARP_REQUEST_BURST )
+    arp_tokens_updated_ms_ = now_ms_; // 桶满了, 多出来的时间不算
+  if ( arp_tokens_ == 0 ) {
+    ++arp_rate_limited_;
+    return false;
+  }
+  --arp_tokens_;
+  return true;
+}
+
+void NetworkInterface::sendARPRequest( uint32_t dst_ip, const EthernetAddress& dst_mac )
+{
+  // 广播ARP request (刷新映射时单播给已知的地址)
   ARPMessage broadcast_arp;
   broadcast_arp.sender_ethernet_address = ethernet_address_;
-  // broadcast_arp.target_ethernet_address ; ARP设置为全0
+  // 广播时 broadcast_arp.target_ethernet_address 设置为全0
+  if ( dst_mac != ETHERNET_BROADCAST )
+    broadcast_arp.target_ethernet_address = dst_mac;
   broadcast_arp.sender_ip_address = ip_address_.ipv4_numeric();
   broadcast_arp.target_ip_address = dst_ip;
   broadcast_arp.opcode = ARPMessage::OPCODE_REQUEST;
   EthernetFrame frame_arp;
   frame_arp.header.src = ethernet_address_;
-  frame_arp.header.dst = ETHERNET_BROADCAST;
+  frame_arp.header.dst = dst_mac;
   frame_arp.header.type = EthernetHeader::TYPE_ARP;
   frame_arp.payload = serialize( broadcast_arp );
   arp_to_send_.push( std::move( frame_arp ) );
+
+  // 创建时就记录广播的ARP请求 (刷新用的单播请求不记录), maybe_send 不用再解析它
+  if ( dst_mac == ETHERNET_BROADCAST && arp_requests_.insert( dst_ip, now_ms_ + ARP_REQUEST_TIMEOUT_MS ).second )
+    request_expiry_.emplace( now_ms_ + ARP_REQUEST_TIMEOUT_MS, dst_ip );
+}
+
+NetworkInterface::HeaderTemplate NetworkInterface::headerTemplate( const EthernetAddress& dst ) const
+{
+  Serializer serializer;
+  EthernetHeader { dst, ethernet_address_, EthernetHeader::TYPE_IPv4 }.serialize( serializer );
+  const string bytes = serializer.release_bytes();
+  HeaderTemplate header_template;
+  memcpy( header_template.data(), bytes.data(), header_template.size() );
+  return header_template;
 }
 
-void NetworkInterface::updateARPTable( const uint32_t& ip, const EthernetAddress& mac )
+void NetworkInterface::updateARPTable( const uint32_t& ip, const EthernetAddress& mac, const bool reply )
 {
   // update ip_mac address
-  if ( ip_mac.find( ip ) == ip_mac.end() ) {
-    ip_mac.insert( { ip, mac } );
-    ip_time.insert( { ip, 0 } );
-  } else {
-    ip_mac[ip] = mac;
-    ip_time[ip] = 0;
+  auto [mapping, inserted] = ip_mac_.insert( ip, { mac, now_ms_ + ARP_MAPPING_TTL_MS } );
+  if ( !inserted ) {
+    // 旧映射过期之前就收到了刷新的回复 (邻居自己的广播请求不算)
+    if ( reply && mapping->refreshing && mapping->expires_at_ms > now_ms_ )
+      ++stalls_avoided_;
+    mapping->expires_at_ms = now_ms_ + ARP_MAPPING_TTL_MS;
+    mapping->refreshing = false;
+  }
+  // 新的邻居, 或者邻居换了地址: 重建头部模板
+  if ( inserted || mapping->ethernet_address != mac ) {
+    mapping->ethernet_address = mac;
+    mapping->header_template = headerTemplate( mac );
+  }
+  mapping_expiry_.emplace( mapping->expires_at_ms, ip );
+  arp_failures_.erase( ip ); // 它又有回应了
+
+  // 一次性发出所有等待这个地址的帧
+  const auto pending = pending_frames_.find( ip );
+  if ( pending != pending_frames_.end() ) {
+    auto& frames = pending->second;
+    while ( !frames.empty() ) {
+      auto& [out, tos] = frames.front();
+      out.frame.header.dst = mac;
+      string& wire = out.wire;
+      memcpy( wire.data(), mapping->header_template.data(), mapping->header_template.size() );
+      ip_to_send_.push( std::move( out ), tos, now_ms_ );
+      frames.pop();
+    }
+    pending_frames_.erase( pending );
   }
 }
\ No newline at end of file
@@ -1,13 +1,19 @@
 #pragma once
 
 #include "address.hh"
+#include "egress_scheduler.hh"
 #include "ethernet_frame.hh"
+#include "flat_hash_map.hh"
 #include "ipv4_datagram.hh"
+#include "pcap.hh"
 
+#include <array>
+#include <functional>
 #include <iostream>
 #include <list>
 #include <optional>
 #include <queue>
+#include <span>
 #include <unordered_map>
 #include <utility>
 
@@ -41,20 +47,101 @@ private:
   // IP (known as Internet-layer or network-layer) address of the interface
   Address ip_address_;
 
-  std::queue<EthernetFrame> ip_to_send_;    // next to send
-  std::queue<EthernetFrame> frame_to_fill_; // queue of Ethernet frames need to fill dst ethernet address
+  EgressScheduler ip_to_send_; // next to send, classified by DSCP
 
-  std::queue<EthernetFrame> arp_to_send_;        // queue of ARP messages
-  std::unordered_map<uint32_t, size_t> arp_time; // record the time of arp message send less than 5000ms
+  // Frames waiting for their next hop's Ethernet address, queued per next-hop IP
+  static constexpr size_t MAX_PENDING_PER_HOP = 64;
+  struct PendingFrame
+  {
+    OutgoingFrame frame;
+    uint8_t tos; // of the datagram inside, to classify the frame once it can be sent
+  };
+  std::unordered_map<uint32_t, std::queue<PendingFrame>> pending_frames_ {};
+  size_t pending_dropped_ {}; // frames dropped because their next hop's queue was full
+  size_t pending_expired_ {}; // frames dropped because the ARP request for their next hop timed out
 
-  std::unordered_map<uint32_t, EthernetAddress>
-    ip_mac;                                     // mapping from ip_address to ethernet_address, Regenerate after 30s
-  std::unordered_map<uint32_t, size_t> ip_time; // record ip_mac life time
+  size_t arp_refreshes_ {};  // unicast ARP requests sent to refresh a mapping still in use
+  size_t stalls_avoided_ {}; // refreshes answered before the old mapping expired
 
-  void updateMappingTime( const size_t ms_since_last_tick );
-  void updateArpTime( const size_t ms_since_last_tick );
-  void broadcastARP( uint32_t dst_ip );
-  void updateARPTable( const uint32_t& ip, const EthernetAddress& mac );
+  std::queue<EthernetFrame> arp_to_send_; // queue of ARP messages
+
+  static constexpr uint64_t ARP_MAPPING_TTL_MS = 30000;   // a learned mapping lasts 30 s
+  static constexpr uint64_t ARP_REQUEST_TIMEOUT_MS = 5000; // an ARP request isn't repeated for 5 s
+  static constexpr uint64_t ARP_REFRESH_WINDOW_MS = 3000;  // a mapping in use is refreshed this close to expiry
+
+  // Broadcast ARP requests are rate-limited per interface (a token bucket: bursts of 32, then one per 10 ms),
+  // so that a scan across many dead addresses can't flood the segment
+  static constexpr uint64_t ARP_REQUEST_BURST = 32;
+  static constexpr uint64_t ARP_REQUEST_INTERVAL_MS = 10;
+  uint64_t arp_tokens_ { ARP_REQUEST_BURST };
+  uint64_t arp_tokens_updated_ms_ {};
+  size_t arp_rate_limited_ {}; // datagrams dropped because no ARP request could be sent for them
+
+  // A next hop that has ignored two requests in a row is negatively cached: datagrams to it are dropped at
+  // once, without a request, for 5 s, doubling with each further failure up to a minute. A failure is
+  // forgotten a minute after its backoff ends.
+  static constexpr uint64_t ARP_BACKOFF_MAX_MS = 60000;
+  static constexpr uint64_t ARP_FAILURE_MEMORY_MS = 60000;
+  struct ArpFailure
+  {
+    uint32_t count {};       // requests in a row that went unanswered
+    uint64_t retry_at_ms {}; // no new request before this time
+    uint64_t forget_at_ms {};
+  };
+  size_t unreachable_dropped_ {}; // datagrams dropped because their next hop is negatively cached
+
+  uint64_t now_ms_ {}; // time since the interface was created
+
+  // Frames to a neighbor all start with the same 14 bytes, so they are serialized once per mapping and
+  // copied into each frame
+  using HeaderTemplate = std::array<char, EthernetHeader::LENGTH>;
+  HeaderTemplate headerTemplate( const EthernetAddress& dst ) const;
+
+  struct ArpEntry
+  {
+    EthernetAddress ethernet_address {};
+    uint64_t expires_at_ms {};
+    bool refreshing {}; // has a unicast ARP request gone out to refresh this mapping?
+    HeaderTemplate header_template {}; // the serialized Ethernet header of an IPv4 frame to this neighbor
+  };
+  // Neighbors' addresses tend to be consecutive, which identity hashing would pack into one long probe run
+  struct IPHash
+  {
+    size_t operator()( const uint32_t ip ) const
+    {
+      uint64_t x = ip * 0x9e3779b97f4a7c15ULL;
+      x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+      return x ^ ( x >> 31 );
+    }
+  };
+  FlatHashMap<uint32_t, ArpEntry, IPHash> ip_mac_ {};      // mapping from ip_address to ethernet_address
+  FlatHashMap<uint32_t, uint64_t, IPHash> arp_requests_ {}; // ARP requests in flight, and when each one expires
+
+  // (expiry time, ip) for every mapping and request, soonest first, so tick() only looks at what expires.
+  // A mapping refreshed since its entry was pushed has a later expiry by then, and its stale entry is skipped.
+  using Expiry = std::pair<uint64_t, uint32_t>;
+  using ExpiryQueue = std::priority_queue<Expiry, std::vector<Expiry>, std::greater<>>;
+  ExpiryQueue mapping_expiry_ {};
+  ExpiryQueue request_expiry_ {};
+  FlatHashMap<uint32_t, ArpFailure, IPHash> arp_failures_ {};
+  ExpiryQueue failure_expiry_ {};
+
+  bool checksum_offload_ {}; // has the hardware already verified the IPv4 header checksum?
+
+public:
+  // Sees each frame the interface sends (serialized), with the interface's time in milliseconds
+  using Capture = std::function<void( std::span<const Buffer> frame, uint64_t now_ms )>;
+
+private:
+  Capture capture_ {};
+
+  void expireMappings();
+  void expireArpRequests();
+  void expireArpFailures();
+  void recordArpFailure( uint32_t ip );
+  bool admitARPRequest( uint32_t ip );
+  void sendARPRequest( uint32_t dst_ip, const EthernetAddress& dst_mac = ETHERNET_BROADCAST );
+  void updateARPTable( const uint32_t& ip, const EthernetAddress& mac, bool reply );
 
 public:
   // Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer)
@@ -64,6 +151,16 @@ public:
   // Access queue of Ethernet frames awaiting transmission
   std::optional<EthernetFrame> maybe_send();
 
+  // The same, but with the frame already serialized in one Buffer, as a driver would hand it to the NIC
+  std::optional<Buffer> maybe_send_serialized();
+
+  // Tap every frame that maybe_send() or maybe_send_serialized() hands out (an empty Capture stops)
+  void set_capture( Capture capture ) { capture_ = std::move( capture ); }
+
+  // The same, recording to a pcap file, timestamped with the time since the interface was created.
+  // The writer must outlive the capture.
+  void set_capture( PcapWriter& writer );
+
   // Sends an IPv4 datagram, encapsulated in an Ethernet frame (if it knows the Ethernet destination
   // address). Will need to use [ARP](\ref rfc::rfc826) to look up the Ethernet destination address
   // for the next hop.
@@ -77,6 +174,34 @@ public:
   // If type is ARP reply, learn a mapping from the "sender" fields.
   std::optional<InternetDatagram> recv_frame( const EthernetFrame& frame );
 
+  // Frames dropped while waiting for ARP (because the queue for their next hop was full, or because the
+  // ARP request went unanswered for 5 seconds)
+  size_t pending_dropped() const { return pending_dropped_; }
+  size_t pending_expired() const { return pending_expired_; }
+
+  // A mapping still in use is refreshed (with a unicast ARP request) in the last 3 seconds before it
+  // expires, so traffic to a busy neighbor never has to wait for a new broadcast request.
+  size_t arp_refreshes() const { return arp_refreshes_; }
+  size_t stalls_avoided() const { return stalls_avoided_; }
+
+  // Datagrams dropped without an ARP request: because the interface had sent too many broadcast requests
+  // recently, or because the next hop has not answered its last requests and is still backing off
+  size_t arp_rate_limited() const { return arp_rate_limited_; }
+  size_t unreachable_dropped() const { return unreachable_dropped_; }
+
+  // Manage the queues of IPv4 frames waiting to be sent (unbounded tail-drop unless configured otherwise).
+  // set_tx_queue() configures the queue of every traffic class; tx_stats() adds up all of them.
+  void set_tx_queue( const TransmitQueueConfig& config ) { ip_to_send_.set_queue_config( config ); }
+  TransmitQueue::Stats tx_stats() const { return ip_to_send_.stats(); }
+
+  // Classify outgoing datagrams by DSCP into several traffic classes, served by strict priority and
+  // deficit round robin (by default there is a single class, i.e. one FIFO)
+  void set_egress( const EgressConfig& config ) { ip_to_send_.set_config( config ); }
+  const TransmitQueue::Stats& tx_stats( size_t traffic_class ) const { return ip_to_send_.stats( traffic_class ); }
+
+  // Skip verifying the IPv4 header checksum of received datagrams (because the NIC already checked it)
+  void set_checksum_offload( bool offload ) { checksum_offload_ = offload; }
+
   // Called periodically when time elapses
   void tick( size_t ms_since_last_tick );
 };
@@ -7,7 +7,7 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
 {
   updateBounds( output );
   // discard:
-  if ( outOfBound( first_index, data ) )
+  if ( outOfBound( first_index, data.length() ) )
     return;
 
   // push to writer immediately
@@ -20,6 +20,42 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
   popValidDomains( output );
 }
 
+void Reassembler::insert( uint64_t first_index, span<const Buffer> data, bool is_last_substring, Writer& output )
+{
+  updateBounds( output );
+  uint64_t length = 0;
+  for ( const auto& b : data )
+    length += b.size();
+  if ( outOfBound( first_index, length ) )
+    return;
+
+  if ( first_index > lower_bound ) {
+    // 乱序: 要存进buffer, 拼接成一个字符串
+    string joined;
+    joined.reserve( length );
+    for ( const auto& b : data )
+      joined.append( static_cast<string_view>( b ) );
+    insertBuffer( first_index, joined, is_last_substring );
+    popValidDomains( output );
+    return;
+  }
+
+  // 按序: 每个Buffer(截掉已经写过的前部)直接交给Writer
+  uint64_t skip = lower_bound - first_index;
+  for ( const auto& b : data ) {
+    if ( skip >= b.size() ) {
+      skip -= b.size();
+      continue;
+    }
+    output.push( skip ? b.slice( skip ) : b );
+    skip = 0;
+  }
+  updateBounds( output );
+  if ( is_last_substring )
+    output.close();
+  popValidDomains( output );
+}
+
 inline void Reassembler::pushToWriter( const string& data, Writer& output, const bool last )
 {
   output.push( data );
@@ -40,11 +76,11 @@ uint64_t Reassembler::bytes_pending() const
   return total_bytes_pending;
 }
 
-bool Reassembler::outOfBound( const uint64_t first_index, const string& data )
+bool Reassembler::outOfBound( const uint64_t first_index, const uint64_t length )
 {
   // The pipe is full or index out of bound.
-  return ( !data.empty() && lower_bound == upper_bound ) || ( first_index >= upper_bound )
-         || ( first_index + data.length() < lower_bound );
+  return ( length && lower_bound == upper_bound ) || ( first_index >= upper_bound )
+         || ( first_index + length < lower_bound );
 }
 
 bool Reassembler::sendNow( const uint64_t first_index, string& data )
@@ -3,6 +3,7 @@
 #include "byte_stream.hh"
 
 #include <list>
+#include <span>
 #include <string>
 #include <unordered_map>
 
@@ -31,6 +32,12 @@ public:
    */
   void insert( uint64_t first_index, std::string data, bool is_last_substring, Writer& output );
 
+  /*
+   * The same, for a substring given as a chain of consecutive Buffers. Bytes that can be written right
+   * away are handed to the Writer as (slices of) those Buffers, without copying.
+   */
+  void insert( uint64_t first_index, std::span<const Buffer> data, bool is_last_substring, Writer& output );
+
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
 
@@ -42,7 +49,7 @@ private:
   uint64_t lower_bound = 0; // next_need_index
   uint64_t upper_bound = 0; // [low_bound, upper_bound)
 
-  bool outOfBound( const uint64_t first_index, const std::string& data );
+  bool outOfBound( const uint64_t first_index, const uint64_t length );
   bool sendNow( const uint64_t first_index, std::string& data );
   void popValidDomains( Writer& output ); // 检查buffer中是否存在可发送的数据，存在则都发送
   void insertBuffer( uint64_t first_index, std::string& data, bool is_last_substring );
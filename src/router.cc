@@ -1,7 +1,7 @@
 #include "router.hh"
 
 #include <iostream>
-#include <limits>
+#include <stdexcept>
 #include <vector>
 
 using namespace std;
@@ -20,27 +20,37 @@ void Router::add_route( const uint32_t route_prefix,
   cerr << "DEBUG: adding route " << Address::from_ipv4_numeric( route_prefix ).ip() << "/"
        << static_cast<int>( prefix_length ) << " => " << ( next_hop.has_value() ? next_hop->ip() : "(direct)" )
        << " on interface " << interface_num << "\n";
-  RouteItem item_to_add = { route_prefix, prefix_length, next_hop, interface_num };
-  route_table.push_back( item_to_add );
+
+  // 相同的下一跳共用一个编号, 转发表里只存编号
+  const uint64_t key = static_cast<uint64_t>( interface_num ) << 33 | uint64_t { next_hop.has_value() } << 32
+                       | ( next_hop.has_value() ? next_hop->ipv4_numeric() : 0 );
+  auto it = next_hop_index_.find( key );
+  if ( it == next_hop_index_.end() ) {
+    if ( next_hops_.size() > Fib::MAX_NEXT_HOP ) {
+      throw length_error( "Router: too many distinct next hops" );
+    }
+    it = next_hop_index_.emplace( key, static_cast<uint16_t>( next_hops_.size() ) ).first;
+    next_hops_.push_back( { next_hop, interface_num } );
+  }
+  fib_.insert( route_prefix, prefix_length, it->second );
 }
 
 void Router::route()
 {
+  fib_.build(); // 只有第一次会建表, 之后加的路由直接更新到表里
   for ( auto& inf : interfaces_ ) {
     optional<InternetDatagram> recved_ipdatagram = inf.maybe_receive();
     if ( recved_ipdatagram.has_value() ) {
       uint32_t ip = recved_ipdatagram.value().header.dst;
-      optional<RouteItem> route_item = longest_prefix_match( ip );
-      auto& ttl = recved_ipdatagram.value().header.ttl;
-      if ( !route_item.has_value() || ttl < 2 )
+      const NextHop* route_item = longest_prefix_match( ip );
+      if ( route_item == nullptr || recved_ipdatagram.value().header.ttl < 2 )
         return; // 匹配失败或者 ttl=1或0 直接丢弃
 
-      // 修改TTL，更新checksum, 发送
-      ttl -= 1;
-      recved_ipdatagram.value().header.compute_checksum();
-      auto& target_interface = interface( route_item.value().interface_num );
-      if ( route_item.value().next_hop.has_value() )
-        target_interface.send_datagram( recved_ipdatagram.value(), route_item.value().next_hop.value() );
+      // 修改TTL，增量更新checksum (RFC 1624), 发送
+      recved_ipdatagram.value().header.decrement_ttl();
+      auto& target_interface = interface( route_item->interface_num );
+      if ( route_item->address.has_value() )
+        target_interface.send_datagram( recved_ipdatagram.value(), route_item->address.value() );
       else {
         // next_hop为空，应该直接发送目标ip
         Address target_ip = Address::from_ipv4_numeric( recved_ipdatagram.value().header.dst );
@@ -50,23 +60,8 @@ void Router::route()
   }
 }
 
-optional<RouteItem> Router::longest_prefix_match( const uint32_t ip )
+const NextHop* Router::longest_prefix_match( const uint32_t ip ) const
 {
-  uint8_t last_length = 0;
-  optional<RouteItem> longest_item;
-  optional<RouteItem> default_route;
-  for ( const auto& item : route_table ) {
-    if ( item.route_prefix == 0 && item.prefix_length == 0 ) {
-      // 默认路由: 0.0.0.0/0
-      default_route = item;
-      continue;
-    }
-    uint32_t mask = -1 << ( 32 - item.prefix_length );
-    bool check = !( ( ip & mask ) ^ item.route_prefix );
-    if ( check && item.prefix_length > last_length ) {
-      last_length = item.prefix_length;
-      longest_item = item;
-    }
-  }
-  return longest_item.has_value() ? longest_item : default_route;
-}
\ No newline at end of file
+  const uint16_t index = fib_.lookup( ip );
+  return index == Fib::NO_ROUTE ? nullptr : &next_hops_[index];
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "fib.hh"
 #include "network_interface.hh"
 
 #include <optional>
@@ -50,11 +51,11 @@ public:
   }
 };
 
-struct RouteItem
+// Where a route sends matching datagrams. Routes with the same next hop share one of these, and the
+// forwarding table refers to it by index.
+struct NextHop
 {
-  uint32_t route_prefix;
-  uint8_t prefix_length;
-  std::optional<Address> next_hop;
+  std::optional<Address> address; // empty if the network is directly attached
   size_t interface_num;
 };
 
@@ -65,10 +66,14 @@ class Router
 private:
   // The router's collection of network interfaces
   std::vector<AsyncNetworkInterface> interfaces_ {};
-  // route_table
-  std::vector<RouteItem> route_table {};
-  // Longest_prefix_match
-  std::optional<RouteItem> longest_prefix_match( const uint32_t ip ); // return interface index
+  // forwarding table, from destination address to an index in next_hops_
+  Fib fib_ {};
+  // next_hops_[0] is unused (Fib::NO_ROUTE)
+  std::vector<NextHop> next_hops_ { { {}, 0 } };
+  // (interface_num, has next hop, next hop address) => index in next_hops_
+  std::unordered_map<uint64_t, uint16_t> next_hop_index_ {};
+  // Longest_prefix_match (nullptr if no route matches)
+  const NextHop* longest_prefix_match( uint32_t ip ) const;
 
 public:
   // Add an interface to the router
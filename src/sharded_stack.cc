@@ -0,0 +1,206 @@
+#include "sharded_stack.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+ShardedStack::ShardedStack( const size_t num_shards,
+                            const TCPConfig& config,
+                            Transmit transmit,
+                            Application application,
+                            const size_t queue_capacity )
+  : config_( config ), transmit_( std::move( transmit ) ), application_( std::move( application ) )
+{
+  if ( num_shards == 0 )
+    throw runtime_error( "ShardedStack needs at least one shard" );
+  for ( size_t i = 0; i < num_shards; ++i )
+    shards_.push_back( make_unique<Shard>( queue_capacity ) );
+}
+
+ShardedStack::~ShardedStack()
+{
+  stop();
+}
+
+void ShardedStack::start()
+{
+  if ( running_.exchange( true ) )
+    return;
+  for ( size_t i = 0; i < shards_.size(); ++i )
+    shards_[i]->worker = thread( [this, i] { run_shard( i ); } );
+}
+
+void ShardedStack::stop()
+{
+  running_.store( false, memory_order_release );
+  for ( auto& shard : shards_ ) {
+    {
+      const lock_guard lock { shard->mutex };
+      shard->wakeup.notify_one();
+    }
+    if ( shard->worker.joinable() )
+      shard->worker.join();
+  }
+}
+
+size_t ShardedStack::shard_of( const ConnectionKey& key ) const
+{
+  // 用哈希的高32位选择分片 (ConnectionTable用的是低位), 乘法代替取模
+  const uint64_t high = ConnectionKeyHash {}( key ) >> 32;
+  return high * shards_.size() >> 32;
+}
+
+bool ShardedStack::deliver( InboundSegment& segment )
+{
+  Shard& shard = *shards_[shard_of( segment.key )];
+  if ( !shard.inbox.try_push( segment ) )
+    return false;
+  // 分片线程可能正在睡眠 (和sleep()里的fence配对, 不会错过唤醒)
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( shard.sleeping.load( memory_order_relaxed ) ) {
+    const lock_guard lock { shard.mutex };
+    shard.wakeup.notify_one();
+  }
+  return true;
+}
+
+uint64_t ShardedStack::segments_processed() const
+{
+  uint64_t total = 0;
+  for ( const auto& shard : shards_ )
+    total += shard->segments_processed.load( memory_order_relaxed );
+  return total;
+}
+
+uint64_t ShardedStack::segments_dropped() const
+{
+  uint64_t total = 0;
+  for ( const auto& shard : shards_ )
+    total += shard->segments_dropped.load( memory_order_relaxed );
+  return total;
+}
+
+void ShardedStack::run_shard( const size_t index )
+{
+  static constexpr size_t batch_size = 64;
+  Shard& shard = *shards_[index];
+  auto last_tick = steady_clock::now();
+
+  while ( running_.load( memory_order_acquire ) ) {
+    size_t processed = 0;
+    while ( processed < batch_size ) {
+      optional<InboundSegment> segment = shard.inbox.try_pop();
+      if ( !segment )
+        break;
+      process( index, segment.value() );
+      ++processed;
+    }
+
+    const auto elapsed = duration_cast<milliseconds>( steady_clock::now() - last_tick );
+    if ( elapsed.count() > 0 ) {
+      last_tick += elapsed;
+      tick( index, elapsed.count() );
+    }
+    if ( !processed )
+      sleep( shard, last_tick );
+  }
+}
+
+void ShardedStack::sleep( Shard& shard, const steady_clock::time_point last_tick )
+{
+  // 队列为空: 睡到下一个定时器到期, 或者有新的数据段到达
+  unique_lock lock { shard.mutex };
+  shard.sleeping.store( true, memory_order_relaxed );
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( shard.inbox.empty() && running_.load( memory_order_acquire ) ) {
+    if ( shard.deadlines.empty() )
+      shard.wakeup.wait( lock );
+    else
+      shard.wakeup.wait_until( lock, last_tick + milliseconds( shard.deadlines.front().at_ms - shard.now_ms ) );
+  }
+  shard.sleeping.store( false, memory_order_relaxed );
+}
+
+void ShardedStack::process( const size_t index, InboundSegment& segment )
+{
+  Shard& shard = *shards_[index];
+  TCPConnection* connection = shard.table.find( segment.key );
+  if ( !connection ) {
+    if ( !segment.message.sender.SYN ) {
+      shard.segments_dropped.store( shard.segments_dropped.load( memory_order_relaxed ) + 1, memory_order_relaxed );
+      return;
+    }
+    connection = &shard.table.open( segment.key, config_ );
+    shard.timers.insert( segment.key, { shard.now_ms } );
+  }
+
+  Timers& timers = *shard.timers.find( segment.key );
+  catch_up( shard, timers, *connection );
+  connection->receive( std::move( segment.message ) );
+  if ( application_ )
+    application_( index, segment.key, *connection );
+  settle( index, segment.key, timers, *connection );
+  // 只有本分片的线程写计数器, 不需要原子的读-改-写
+  shard.segments_processed.store( shard.segments_processed.load( memory_order_relaxed ) + 1, memory_order_relaxed );
+}
+
+void ShardedStack::tick( const size_t index, const uint64_t ms_since_last_tick )
+{
+  Shard& shard = *shards_[index];
+  shard.now_ms += ms_since_last_tick;
+
+  // 只处理定时器已经到期的连接
+  while ( !shard.deadlines.empty() && shard.deadlines.front().at_ms <= shard.now_ms ) {
+    pop_heap( shard.deadlines.begin(), shard.deadlines.end(), greater<> {} );
+    const Deadline due = shard.deadlines.back();
+    shard.deadlines.pop_back();
+
+    Timers* timers = shard.timers.find( due.key );
+    if ( !timers || timers->scheduled_ms != due.at_ms )
+      continue; // 连接已经关闭, 或者这个条目已经过时
+    timers->scheduled_ms = NO_DEADLINE;
+    TCPConnection& connection = *shard.table.find( due.key );
+    catch_up( shard, *timers, connection );
+    settle( index, due.key, *timers, connection );
+  }
+}
+
+void ShardedStack::catch_up( const Shard& shard, Timers& timers, TCPConnection& connection )
+{
+  if ( shard.now_ms > timers.synced_ms )
+    connection.tick( shard.now_ms - timers.synced_ms );
+  timers.synced_ms = shard.now_ms;
+}
+
+void ShardedStack::settle( const size_t index, const ConnectionKey& key, Timers& timers, TCPConnection& connection )
+{
+  Shard& shard = *shards_[index];
+  flush( index, key, connection );
+  if ( !connection.active() ) {
+    shard.table.close( key );
+    shard.timers.erase( key );
+    return;
+  }
+
+  // 定时器提前了才需要新的条目, 推迟的话旧条目到期时再重新安排
+  const optional<uint64_t> ms = connection.ms_until_deadline();
+  if ( !ms )
+    return;
+  const uint64_t at_ms = shard.now_ms + max<uint64_t>( ms.value(), 1 );
+  if ( at_ms < timers.scheduled_ms ) {
+    timers.scheduled_ms = at_ms;
+    shard.deadlines.push_back( { at_ms, key } );
+    push_heap( shard.deadlines.begin(), shard.deadlines.end(), greater<> {} );
+  }
+}
+
+void ShardedStack::flush( const size_t index, const ConnectionKey& key, TCPConnection& connection )
+{
+  while ( auto message = connection.maybe_send() ) {
+    if ( transmit_ )
+      transmit_( index, key, std::move( message.value() ) );
+  }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "connection_table.hh"
+#include "flat_hash_map.hh"
+#include "spsc_queue.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A segment addressed to one of the local connections
+struct InboundSegment
+{
+  ConnectionKey key {};
+  TCPMessage message {};
+};
+
+// A TCP stack split into shards, each run by its own worker thread.
+//
+// Every connection belongs to exactly one shard, chosen by a hash of its 4-tuple (like RSS on a
+// multi-queue NIC). The thread that receives frames steers each segment into the owning shard's
+// single-producer/single-consumer queue, and only that shard's worker ever touches the
+// connection, so there are no locks on the per-segment path.
+//
+// A segment with SYN set for an unknown 4-tuple opens a new connection (a passive open); other
+// segments for unknown 4-tuples are dropped.
+//
+// Each shard keeps its connections' deadlines (retransmission timeouts and delayed ACKs) in a
+// min-heap, and only touches a connection when a segment arrives for it or its deadline passes, so
+// idle connections cost nothing. A shard with nothing to do sleeps until its next deadline or the
+// next segment.
+class ShardedStack
+{
+public:
+  // Called on a shard's worker thread for every segment the shard has to transmit
+  using Transmit = std::function<void( size_t shard, const ConnectionKey& key, TCPMessage message )>;
+
+  // Called on a shard's worker thread after a segment has been delivered to a connection,
+  // so the application can read from and write to it
+  using Application = std::function<void( size_t shard, const ConnectionKey& key, TCPConnection& connection )>;
+
+private:
+  static constexpr uint64_t NO_DEADLINE = std::numeric_limits<uint64_t>::max();
+
+  // A connection's clock, kept lazily: it is only ticked up to the shard's clock when it is touched
+  struct Timers
+  {
+    uint64_t synced_ms {};                // the shard's clock when the connection was last ticked
+    uint64_t scheduled_ms { NO_DEADLINE }; // the connection's live entry in the deadline heap
+  };
+
+  struct Deadline
+  {
+    uint64_t at_ms;
+    ConnectionKey key;
+
+    bool operator>( const Deadline& other ) const { return at_ms > other.at_ms; }
+  };
+
+  struct Shard
+  {
+    explicit Shard( size_t queue_capacity ) : inbox( queue_capacity ) {}
+
+    ConnectionTable table {};
+    SPSCQueue<InboundSegment> inbox;
+    std::atomic<uint64_t> segments_processed { 0 }; // written only by the worker
+    std::atomic<uint64_t> segments_dropped { 0 };   // written only by the worker
+    std::thread worker {};
+
+    // Only the worker touches these
+    uint64_t now_ms {};
+    FlatHashMap<ConnectionKey, Timers, ConnectionKeyHash> timers {};
+    std::vector<Deadline> deadlines {}; // a min-heap (std::greater); entries whose time no longer
+                                        // matches the connection's scheduled_ms are stale
+
+    // For the worker to sleep on while its inbox is empty
+    std::mutex mutex {};
+    std::condition_variable wakeup {};
+    std::atomic<bool> sleeping { false };
+  };
+
+  TCPConfig config_;
+  Transmit transmit_;
+  Application application_;
+  std::vector<std::unique_ptr<Shard>> shards_ {};
+  std::atomic<bool> running_ { false };
+
+  void run_shard( size_t index );
+  void process( size_t index, InboundSegment& segment );
+  void tick( size_t index, uint64_t ms_since_last_tick );
+  void sleep( Shard& shard, std::chrono::steady_clock::time_point last_tick );
+  void catch_up( const Shard& shard, Timers& timers, TCPConnection& connection );
+  void settle( size_t index, const ConnectionKey& key, Timers& timers, TCPConnection& connection );
+  void flush( size_t index, const ConnectionKey& key, TCPConnection& connection );
+
+public:
+  ShardedStack( size_t num_shards,
+                const TCPConfig& config,
+                Transmit transmit,
+                Application application = {},
+                size_t queue_capacity = 4096 );
+  ~ShardedStack();
+
+  ShardedStack( const ShardedStack& other ) = delete;
+  ShardedStack& operator=( const ShardedStack& other ) = delete;
+
+  // Start and stop the worker threads. Segments still queued when the stack stops are discarded.
+  void start();
+  void stop();
+
+  size_t num_shards() const { return shards_.size(); }
+
+  // Which shard owns the connection with this 4-tuple?
+  size_t shard_of( const ConnectionKey& key ) const;
+
+  // Hand a segment to the shard that owns its connection. Must always be called from the same thread.
+  // Returns false (leaving `segment` untouched) if that shard's queue is full.
+  bool deliver( InboundSegment& segment );
+
+  // Totals across all shards
+  uint64_t segments_processed() const;
+  uint64_t segments_dropped() const;
+};
@@ -0,0 +1,55 @@
+#include "tcp_connection.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+TCPConnection::TCPConnection( const TCPConfig& config )
+  : outbound_( config.send_capacity )
+  , inbound_( config.recv_capacity )
+  , sender_( config.rt_timeout, config.fixed_isn )
+  , receiver_( config )
+{}
+
+void TCPConnection::receive( TCPMessage message )
+{
+  receiver_.receive( std::move( message.sender ), reassembler_, inbound_.writer() );
+  sender_.receive( message.receiver );
+}
+
+optional<TCPMessage> TCPConnection::maybe_send()
+{
+  sender_.push( outbound_.reader() );
+  optional<TCPSenderMessage> seg = sender_.maybe_send();
+  if ( seg ) {
+    // ACK搭载在数据段上发出
+    receiver_.ack_sent( inbound_.writer() );
+    return TCPMessage { std::move( seg.value() ), receiver_.send( inbound_.writer() ) };
+  }
+  optional<TCPReceiverMessage> ack = receiver_.maybe_send( inbound_.writer() );
+  if ( ack )
+    return TCPMessage { sender_.send_empty_message(), ack.value() };
+  return {};
+}
+
+void TCPConnection::tick( const uint64_t ms_since_last_tick )
+{
+  sender_.tick( ms_since_last_tick );
+  receiver_.tick( ms_since_last_tick );
+}
+
+optional<uint64_t> TCPConnection::ms_until_deadline() const
+{
+  const optional<uint64_t> timeout = sender_.ms_until_timeout();
+  const optional<uint64_t> ack = receiver_.ms_until_ack();
+  if ( timeout && ack )
+    return min( timeout.value(), ack.value() );
+  return timeout ? timeout : ack;
+}
+
+bool TCPConnection::active() const
+{
+  if ( sender_.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS )
+    return false;
+  return !( inbound_.reader().is_finished() && sender_.fin_sent() && sender_.sequence_numbers_in_flight() == 0 );
+}
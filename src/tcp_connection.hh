@@ -0,0 +1,54 @@
+#pragma once
+
+#include "byte_stream.hh"
+#include "reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_message.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <optional>
+
+// A TCP connection: one TCPSender and one TCPReceiver, together with the outbound ByteStream
+// the sender reads from and the Reassembler and inbound ByteStream the receiver writes to.
+//
+// Every outgoing segment carries both halves: the sender's next segment (or an empty one) and
+// the receiver's current ackno and window. Pure ACKs are only generated when the receiver's
+// delayed-ACK policy says one is due.
+class TCPConnection
+{
+private:
+  ByteStream outbound_;
+  ByteStream inbound_;
+  Reassembler reassembler_ {};
+  TCPSender sender_;
+  TCPReceiver receiver_;
+
+public:
+  explicit TCPConnection( const TCPConfig& config );
+
+  // The application writes to the outbound stream and reads from the inbound stream
+  Writer& outbound_writer() { return outbound_.writer(); }
+  Reader& inbound_reader() { return inbound_.reader(); }
+  const Reader& inbound_reader() const { return inbound_.reader(); }
+
+  // Receive a segment from the peer
+  void receive( TCPMessage message );
+
+  // The next segment to transmit (or empty optional if there is nothing to send)
+  std::optional<TCPMessage> maybe_send();
+
+  // Time has passed by the given # of milliseconds since the last time the tick() method was called
+  void tick( uint64_t ms_since_last_tick );
+
+  // Milliseconds until tick() next has work to do: a retransmission timeout or a delayed ACK
+  // (or empty optional if neither timer is running)
+  std::optional<uint64_t> ms_until_deadline() const;
+
+  // Is the connection still doing anything? (False once both streams have finished and
+  // everything has been acknowledged, or once the sender has given up retransmitting.)
+  bool active() const;
+
+  const TCPSender& sender() const { return sender_; }
+  const TCPReceiver& receiver() const { return receiver_; }
+};
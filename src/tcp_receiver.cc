@@ -1,20 +1,85 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+#include <vector>
+
 using namespace std;
 
+TCPReceiver::TCPReceiver( const TCPConfig& config )
+  : ack_delay_ms_( config.ack_delay )
+  , autotune_( config.recv_autotune )
+  , min_capacity_( config.recv_min_capacity )
+  , max_capacity_( config.recv_max_capacity )
+{}
+
 void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, Writer& inbound_stream )
+{
+  receiveSegment( message, { &message.payload, 1 }, reassembler, inbound_stream );
+}
+
+void TCPReceiver::receiveSegment( const TCPSenderMessage& message,
+                                  span<const Buffer> payload,
+                                  Reassembler& reassembler,
+                                  Writer& inbound_stream )
 {
   if ( !isn && !message.SYN )
     // 未建立TCP连接时直接丢弃非SYN包
     return;
-  if ( !isn && message.SYN )
+  if ( !isn && message.SYN ) {
     // 建立TCP连接
     isn = message.seqno;
+    if ( autotune_ ) {
+      // 从最小窗口开始, 按测得的带宽时延积增长
+      inbound_stream.set_capacity( min_capacity_ );
+      space_start_ms_ = now_ms_;
+    }
+  }
   const uint64_t check_point = inbound_stream.bytes_pushed() + 1;              // stream index to abs_seqnno
   const uint64_t abs_seqno = message.seqno.unwrap( isn.value(), check_point ); // abs_seqno
   // convert to stream index
   const uint64_t first_index = message.SYN ? 0 : abs_seqno - 1;
-  reassembler.insert( first_index, std::move( message.payload ), message.FIN, inbound_stream );
+  const uint64_t pushed_before = inbound_stream.bytes_pushed();
+  const bool gap = reassembler.bytes_pending() > 0;
+  uint64_t payload_size = 0;
+  for ( const auto& b : payload )
+    payload_size += b.size();
+  updateAckState( message, payload_size, first_index, pushed_before, gap );
+  reassembler.insert( first_index, payload, message.FIN, inbound_stream );
+  if ( autotune_ )
+    autotune( inbound_stream );
+}
+
+void TCPReceiver::receive_batch( span<const TCPSenderMessage> messages,
+                                 Reassembler& reassembler,
+                                 Writer& inbound_stream )
+{
+  size_t i = 0;
+  while ( i < messages.size() ) {
+    // 找出从i开始的一段连续的数据段: [i, j)
+    size_t j = i + 1;
+    if ( isn && !messages[i].SYN && !messages[i].FIN && !messages[i].payload.empty() ) {
+      Wrap32 next_seqno = messages[i].seqno + messages[i].sequence_length();
+      while ( j < messages.size() && !messages[j].SYN && !messages[j].payload.empty()
+              && messages[j].seqno == next_seqno ) {
+        next_seqno = next_seqno + messages[j].sequence_length();
+        if ( messages[j++].FIN )
+          break;
+      }
+    }
+    if ( j == i + 1 ) {
+      receive( messages[i], reassembler, inbound_stream );
+      ++i;
+      continue;
+    }
+
+    // 合并为一个段, 只插入一次; 各段的payload串成一条链, 不拷贝
+    const TCPSenderMessage merged { messages[i].seqno, false, {}, messages[j - 1].FIN };
+    vector<Buffer> chain;
+    chain.reserve( j - i );
+    for ( ; i < j; ++i )
+      chain.push_back( messages[i].payload );
+    receiveSegment( merged, chain, reassembler, inbound_stream );
+  }
 }
 
 TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
@@ -30,7 +95,110 @@ TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
   return send_msg;
 }
 
+optional<TCPReceiverMessage> TCPReceiver::maybe_send( const Writer& inbound_stream )
+{
+  if ( !isn )
+    return {};
+  if ( ack_now_ || ( ack_pending_ && ack_timer_ms_ >= ack_delay_ms_ ) ) {
+    ack_sent( inbound_stream );
+    return send( inbound_stream );
+  }
+  return {};
+}
+
+void TCPReceiver::ack_sent( const Writer& inbound_stream )
+{
+  unacked_bytes_ = 0;
+  ack_timer_ms_ = 0;
+  ack_pending_ = false;
+  ack_now_ = false;
+  // 记录已通告的窗口右边界
+  advertised_edge_ = max( advertised_edge_, inbound_stream.bytes_pushed() + send( inbound_stream ).window_size );
+}
+
+void TCPReceiver::tick( const uint64_t ms_since_last_tick )
+{
+  now_ms_ += ms_since_last_tick;
+  if ( ack_pending_ )
+    ack_timer_ms_ += ms_since_last_tick;
+}
+
+bool TCPReceiver::ack_pending() const
+{
+  return ack_pending_ || ack_now_;
+}
+
+optional<uint64_t> TCPReceiver::ms_until_ack() const
+{
+  if ( ack_now_ )
+    return 0;
+  if ( !ack_pending_ )
+    return {};
+  return ack_timer_ms_ >= ack_delay_ms_ ? 0 : ack_delay_ms_ - ack_timer_ms_;
+}
+
+uint64_t TCPReceiver::rtt_estimate() const
+{
+  return rtt_ms_;
+}
+
+void TCPReceiver::autotune( Writer& inbound_stream )
+{
+  const uint64_t pushed = inbound_stream.bytes_pushed();
+
+  // 发送端每个RTT最多发出一个窗口, 收满一个窗口所用的时间可以作为RTT的估计
+  if ( rtt_probe_ && pushed >= rtt_probe_->first ) {
+    const uint64_t sample = now_ms_ - rtt_probe_->second;
+    if ( sample )
+      rtt_ms_ = ( !rtt_ms_ || sample < rtt_ms_ ) ? sample : ( 7 * rtt_ms_ + sample ) / 8;
+    rtt_probe_.reset();
+  }
+  if ( !rtt_probe_ )
+    rtt_probe_ = { pushed + max<uint64_t>( inbound_stream.available_capacity(), 1 ), now_ms_ };
+
+  // 每个RTT调整一次容量: 2 * 交付速率 * RTT
+  const uint64_t elapsed = now_ms_ - space_start_ms_;
+  if ( !rtt_ms_ || elapsed < rtt_ms_ )
+    return;
+  const uint64_t delivered_per_rtt = ( pushed - space_start_bytes_ ) * rtt_ms_ / elapsed;
+  const uint64_t target = clamp( 2 * delivered_per_rtt, min_capacity_, max_capacity_ );
+  space_start_ms_ = now_ms_;
+  space_start_bytes_ = pushed;
+
+  const uint64_t capacity = inbound_stream.capacity();
+  if ( target > capacity ) {
+    inbound_stream.set_capacity( target );
+    return;
+  }
+  // 收缩时已经通告给对端的窗口右边界不能后退
+  const uint64_t promised = advertised_edge_ > pushed ? advertised_edge_ - pushed : 0;
+  const uint64_t lowest = capacity - inbound_stream.available_capacity() + promised;
+  const uint64_t shrunk = max( target, lowest );
+  if ( shrunk < capacity )
+    inbound_stream.set_capacity( shrunk );
+}
+
+void TCPReceiver::updateAckState( const TCPSenderMessage& message,
+                                  const uint64_t payload_size,
+                                  const uint64_t first_index,
+                                  const uint64_t pushed_before,
+                                  const bool gap )
+{
+  if ( !message.SYN && !message.FIN && !payload_size )
+    return; // 纯ACK不需要确认
+  ack_pending_ = true;
+  // SYN、FIN、乱序(或重复)数据以及填补空洞的数据都要立即确认
+  if ( message.SYN || message.FIN || first_index != pushed_before || gap || ack_delay_ms_ == 0 ) {
+    ack_now_ = true;
+    return;
+  }
+  // 每两个满载的段确认一次
+  unacked_bytes_ += payload_size;
+  if ( unacked_bytes_ >= 2 * TCPConfig::MAX_PAYLOAD_SIZE )
+    ack_now_ = true;
+}
+
 inline uint16_t TCPReceiver::u64ToU16( uint64_t num_64 ) const
 {
   return num_64 > UINT16_MAX ? UINT16_MAX : num_64;
-}
\ No newline at end of file
+}
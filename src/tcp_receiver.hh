@@ -1,8 +1,11 @@
 #pragma once
 #include "reassembler.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 #include <optional>
+#include <span>
+#include <utility>
 
 class TCPReceiver
 {
@@ -10,13 +13,80 @@ private:
   std::optional<Wrap32> isn = {};
   inline uint16_t u64ToU16( uint64_t num_64 ) const;
 
+  // Delayed ACK state
+  uint64_t ack_delay_ms_ = TCPConfig::ACK_DELAY_DFLT; // 最长延迟确认时间
+  uint64_t unacked_bytes_ = 0;                        // 上次ACK之后按序到达的字节数
+  uint64_t ack_timer_ms_ = 0;                         // 最早的未确认数据已等待的时间
+  bool ack_pending_ = false;                          // 有数据到达但还未确认
+  bool ack_now_ = false;                              // 下一个ACK不能延迟
+
+  void updateAckState( const TCPSenderMessage& message,
+                       uint64_t payload_size,
+                       uint64_t first_index,
+                       uint64_t pushed_before,
+                       bool gap );
+  void receiveSegment( const TCPSenderMessage& message,
+                       std::span<const Buffer> payload,
+                       Reassembler& reassembler,
+                       Writer& inbound_stream );
+
+  // Receive-window auto-tuning state
+  bool autotune_ = false;
+  uint64_t min_capacity_ = TCPConfig::MIN_RECV_CAPACITY;
+  uint64_t max_capacity_ = TCPConfig::MAX_RECV_CAPACITY;
+  uint64_t now_ms_ = 0;                                       // 接收端时钟
+  std::optional<std::pair<uint64_t, uint64_t>> rtt_probe_ {}; // 测量RTT: {结束时的bytes_pushed, 开始时间}
+  uint64_t rtt_ms_ = 0;                                       // 平滑后的RTT估计, 0为未知
+  uint64_t space_start_ms_ = 0;                               // 当前RTT内交付量的统计起点
+  uint64_t space_start_bytes_ = 0;
+  uint64_t advertised_edge_ = 0;                              // 已通告的窗口右边界, 收缩时不能越过
+
+  void autotune( Writer& inbound_stream );
+
 public:
+  TCPReceiver() = default;
+  explicit TCPReceiver( const TCPConfig& config );
+
   /*
    * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
    * at the correct stream index.
    */
   void receive( TCPSenderMessage message, Reassembler& reassembler, Writer& inbound_stream );
 
+  /*
+   * Receive a burst of TCPSenderMessages at once. Runs of consecutive in-order segments are coalesced
+   * and inserted into the Reassembler as one substring (a chain of their payload Buffers, not a copy),
+   * so a bulk burst pays for a single unwrap and insert.
+   */
+  void receive_batch( std::span<const TCPSenderMessage> messages,
+                      Reassembler& reassembler,
+                      Writer& inbound_stream );
+
   /* The TCPReceiver sends TCPReceiverMessages back to the TCPSender. */
   TCPReceiverMessage send( const Writer& inbound_stream ) const;
+
+  /*
+   * Delayed ACK: returns a TCPReceiverMessage if an acknowledgment is due now (or empty optional if it can
+   * still be held back). An ACK is due after every second full-sized segment, after `ack_delay` ms, or
+   * immediately for SYN, FIN, out-of-order or gap-filling segments.
+   */
+  std::optional<TCPReceiverMessage> maybe_send( const Writer& inbound_stream );
+
+  /*
+   * The current ackno and window have reached the peer some other way (e.g. piggybacked on outgoing data).
+   * The window is a promise to the peer, so auto-tuning never shrinks the capacity behind its right edge.
+   */
+  void ack_sent( const Writer& inbound_stream );
+
+  /* Time has passed by the given # of milliseconds since the last time the tick() method was called. */
+  void tick( uint64_t ms_since_last_tick );
+
+  /* Is there received data that has not been acknowledged yet? */
+  bool ack_pending() const;
+
+  /* Milliseconds until a delayed ACK becomes due (0 if one is due now, or empty optional if none is pending). */
+  std::optional<uint64_t> ms_until_ack() const;
+
+  /* Smoothed round-trip time estimated from the arrival of whole windows (0 if not yet measured). */
+  uint64_t rtt_estimate() const;
 };
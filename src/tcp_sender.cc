@@ -38,6 +38,18 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retrans_cnt_;
 }
 
+bool TCPSender::fin_sent() const
+{
+  return fin_send_;
+}
+
+optional<uint64_t> TCPSender::ms_until_timeout() const
+{
+  if ( !retrans_timer_.is_running() )
+    return {};
+  return retrans_timer_.get_remaining_time();
+}
+
 optional<TCPSenderMessage> TCPSender::maybe_send()
 {
   optional<TCPSenderMessage> seg_maybe_send;
@@ -216,6 +228,11 @@ inline uint64_t Timer::get_round_time() const
   return round_time_;
 }
 
+inline uint64_t Timer::get_remaining_time() const
+{
+  return round_time_ >= RTO_ms_ ? 0 : RTO_ms_ - round_time_;
+}
+
 inline void Timer::increase_round_time( const size_t ms )
 {
   round_time_ += ms;
@@ -25,6 +25,7 @@ public:
   inline bool is_running() const;
   inline bool is_expired() const;
   inline uint64_t get_round_time() const;
+  inline uint64_t get_remaining_time() const;
 
   inline void increase_round_time( const size_t ms );
 };
@@ -74,4 +75,8 @@ public:
   /* Accessors for use in testing */
   uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  bool fin_sent() const;                        // Has the FIN (end of the outbound stream) been sent?
+
+  /* Milliseconds until the retransmission timer expires (or empty optional if it is not running) */
+  std::optional<uint64_t> ms_until_timeout() const;
 };
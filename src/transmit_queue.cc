@@ -0,0 +1,143 @@
+#include "transmit_queue.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void TransmitQueue::push( OutgoingFrame frame, const uint64_t now_ms )
+{
+  if ( config_.discipline == QueueDiscipline::RED && red_drop( now_ms ) ) {
+    ++stats_.early_drops;
+    return;
+  }
+  if ( config_.limit && frames_.size() >= config_.limit ) {
+    ++stats_.tail_drops;
+    return;
+  }
+  frames_.push_back( { std::move( frame ), now_ms } );
+  ++stats_.enqueued;
+}
+
+optional<OutgoingFrame> TransmitQueue::pop( const uint64_t now_ms )
+{
+  optional<Queued> next;
+  if ( config_.discipline == QueueDiscipline::CoDel ) {
+    next = codel_pop( now_ms );
+  } else if ( !frames_.empty() ) {
+    next = std::move( frames_.front() );
+    frames_.pop_front();
+  }
+  if ( !next )
+    return {};
+
+  if ( frames_.empty() )
+    red_idle_since_ms_ = now_ms;
+  const uint64_t delay = now_ms - next->enqueued_ms;
+  ++stats_.dequeued;
+  stats_.total_delay_ms += delay;
+  stats_.max_delay_ms = max( stats_.max_delay_ms, delay );
+  return std::move( next->frame );
+}
+
+// 平均队列长度在 [min, max) 之间时按概率丢弃, 两次丢弃之间隔得越久概率越大 (Floyd & Jacobson 1993)
+bool TransmitQueue::red_drop( const uint64_t now_ms )
+{
+  const double w = config_.red_weight;
+  if ( frames_.empty() ) {
+    // 队列空闲期间平均长度继续衰减 (当作每毫秒采样一次空队列)
+    red_average_ *= pow( 1 - w, static_cast<double>( now_ms - red_idle_since_ms_ ) );
+    red_idle_since_ms_ = now_ms;
+  } else {
+    red_average_ = ( 1 - w ) * red_average_ + w * static_cast<double>( frames_.size() );
+  }
+
+  if ( red_average_ < config_.red_min_threshold ) {
+    red_count_ = 0;
+    return false;
+  }
+  if ( red_average_ >= config_.red_max_threshold ) {
+    red_count_ = 0;
+    return true;
+  }
+
+  const double p_b = config_.red_max_p * ( red_average_ - config_.red_min_threshold )
+                     / ( config_.red_max_threshold - config_.red_min_threshold );
+  const double spread = 1 - static_cast<double>( red_count_ ) * p_b;
+  const double p_a = spread > 0 ? p_b / spread : 1;
+  ++red_count_;
+  if ( uniform_real_distribution<double> { 0, 1 }( red_random_ ) < p_a ) {
+    red_count_ = 0;
+    return true;
+  }
+  return false;
+}
+
+// RFC 8289 的 dodequeue: 取出队头, 并判断排队时延是否已经在 target 之上停留了一个 interval
+optional<TransmitQueue::Queued> TransmitQueue::codel_dequeue( const uint64_t now_ms, bool& ok_to_drop )
+{
+  ok_to_drop = false;
+  if ( frames_.empty() ) {
+    codel_first_above_ms_ = 0;
+    return {};
+  }
+  optional<Queued> next { std::move( frames_.front() ) };
+  frames_.pop_front();
+
+  const uint64_t sojourn = now_ms - next->enqueued_ms;
+  if ( sojourn < config_.codel_target_ms || frames_.empty() ) {
+    codel_first_above_ms_ = 0; // 时延降下来了, 或者队列里只剩不到一个帧
+  } else if ( codel_first_above_ms_ == 0 ) {
+    codel_first_above_ms_ = now_ms + config_.codel_interval_ms;
+  } else if ( now_ms >= codel_first_above_ms_ ) {
+    ok_to_drop = true;
+  }
+  return next;
+}
+
+// RFC 8289 的 dequeue: 进入丢弃状态以后, 丢弃间隔按 interval / sqrt(count) 缩短, 直到时延回到 target 以下
+optional<TransmitQueue::Queued> TransmitQueue::codel_pop( const uint64_t now_ms )
+{
+  bool ok_to_drop = false;
+  optional<Queued> next = codel_dequeue( now_ms, ok_to_drop );
+  if ( !next ) {
+    codel_dropping_ = false;
+    return {};
+  }
+
+  if ( codel_dropping_ ) {
+    if ( !ok_to_drop )
+      codel_dropping_ = false;
+    while ( codel_dropping_ && now_ms >= codel_drop_next_ms_ ) {
+      ++stats_.codel_drops;
+      ++codel_count_;
+      next = codel_dequeue( now_ms, ok_to_drop );
+      if ( !next ) {
+        codel_dropping_ = false;
+        return {};
+      }
+      if ( !ok_to_drop )
+        codel_dropping_ = false;
+      else
+        codel_drop_next_ms_ = codel_control_law( codel_drop_next_ms_ );
+    }
+  } else if ( ok_to_drop ) {
+    ++stats_.codel_drops;
+    next = codel_dequeue( now_ms, ok_to_drop );
+    codel_dropping_ = true;
+    // 如果刚离开丢弃状态不久, 从上次的丢弃速率附近继续
+    const uint64_t delta = codel_count_ - codel_last_count_;
+    const bool recent = now_ms < codel_drop_next_ms_ + 16 * config_.codel_interval_ms;
+    codel_count_ = ( delta > 1 && recent ) ? delta : 1;
+    codel_drop_next_ms_ = codel_control_law( now_ms );
+    codel_last_count_ = codel_count_;
+  }
+  return next;
+}
+
+uint64_t TransmitQueue::codel_control_law( const uint64_t t ) const
+{
+  const double spacing
+    = static_cast<double>( config_.codel_interval_ms ) / sqrt( static_cast<double>( codel_count_ ) );
+  return t + max<uint64_t>( 1, static_cast<uint64_t>( spacing ) );
+}
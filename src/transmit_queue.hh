@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ethernet_frame.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <random>
+
+// A frame on its way out of a NetworkInterface, together with its bytes as they will go on the wire (built
+// once, when the frame is queued; `frame.payload` is a slice of them). It is only handed out as one or the
+// other, so the two can't disagree.
+struct OutgoingFrame
+{
+  EthernetFrame frame {};
+  Buffer wire {};
+};
+
+enum class QueueDiscipline
+{
+  TailDrop, // drop arrivals only when the queue is full
+  RED,      // Random Early Detection: drop arrivals with a probability that grows with the average length
+  CoDel,    // Controlled Delay (RFC 8289): drop departures once the sojourn time stays above target
+};
+
+// Config for a TransmitQueue
+struct TransmitQueueConfig
+{
+  QueueDiscipline discipline = QueueDiscipline::TailDrop;
+  size_t limit = 0; // frames held before tail drop, under every discipline (0 means unlimited)
+
+  double red_min_threshold = 5;  // average length (in frames) where RED starts dropping
+  double red_max_threshold = 15; // average length where RED drops every arrival
+  double red_max_p = 0.1;        // drop probability just below the max threshold
+  double red_weight = 0.002;     // weight of each arrival in the average length
+
+  uint64_t codel_target_ms = 5;     // acceptable standing delay
+  uint64_t codel_interval_ms = 100; // how long delay may stay above target before CoDel drops
+};
+
+// A bounded FIFO of frames waiting to be transmitted, with active queue management.
+//
+// Every frame is stamped with the time it was queued, so the queue knows each frame's sojourn time
+// (how long it waited) when it leaves. Under overload a plain tail-drop queue fills up and then
+// keeps every frame waiting for as long as it takes to drain a full queue; RED and CoDel drop
+// early instead, keeping the standing queue (and so the delay) short.
+class TransmitQueue
+{
+public:
+  struct Stats
+  {
+    uint64_t enqueued {};
+    uint64_t dequeued {};
+    uint64_t tail_drops {};  // arrivals dropped because the queue was full
+    uint64_t early_drops {}; // arrivals dropped by RED
+    uint64_t codel_drops {}; // departures dropped by CoDel
+    uint64_t total_delay_ms {};
+    uint64_t max_delay_ms {};
+
+    uint64_t drops() const { return tail_drops + early_drops + codel_drops; }
+    double average_delay_ms() const { return dequeued ? static_cast<double>( total_delay_ms ) / dequeued : 0; }
+  };
+
+private:
+  struct Queued
+  {
+    OutgoingFrame frame;
+    uint64_t enqueued_ms;
+  };
+
+  TransmitQueueConfig config_;
+  std::deque<Queued> frames_ {};
+  Stats stats_ {};
+
+  // RED
+  double red_average_ {};
+  uint64_t red_count_ {}; // arrivals since the last early drop
+  uint64_t red_idle_since_ms_ {};
+  std::minstd_rand red_random_ {};
+
+  // CoDel
+  uint64_t codel_first_above_ms_ {}; // when the sojourn time will have been above target for an interval
+  uint64_t codel_drop_next_ms_ {};
+  uint64_t codel_count_ {};
+  uint64_t codel_last_count_ {};
+  bool codel_dropping_ {};
+
+  bool red_drop( uint64_t now_ms );
+  std::optional<Queued> codel_dequeue( uint64_t now_ms, bool& ok_to_drop );
+  std::optional<Queued> codel_pop( uint64_t now_ms );
+  uint64_t codel_control_law( uint64_t t ) const;
+
+public:
+  explicit TransmitQueue( const TransmitQueueConfig& config = {} ) : config_( config ) {}
+
+  // Change the configuration, keeping any frames already queued
+  void set_config( const TransmitQueueConfig& config ) { config_ = config; }
+  const TransmitQueueConfig& config() const { return config_; }
+
+  // Queue a frame (or drop it, as the discipline decides)
+  void push( OutgoingFrame frame, uint64_t now_ms );
+
+  // The next frame to transmit, if any
+  std::optional<OutgoingFrame> pop( uint64_t now_ms );
+
+  // Bytes on the wire of the frame at the head of the queue (0 if the queue is empty)
+  size_t front_bytes() const { return frames_.empty() ? 0 : frames_.front().frame.wire.size(); }
+
+  size_t size() const { return frames_.size(); }
+  bool empty() const { return frames_.empty(); }
+  const Stats& stats() const { return stats_; }
+};
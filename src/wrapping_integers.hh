@@ -29,5 +29,6 @@ public:
   uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const;
 
   Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
+  uint32_t raw_value() const { return raw_value_; } // the 32-bit value as carried in a TCP header
   bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
 };
@@ -0,0 +1,145 @@
+#include "buffer.hh"
+#include "parser.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void expect( const bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+void check_slices()
+{
+  const Buffer whole { string( "0123456789" ) };
+  const Buffer middle = whole.slice( 2, 5 );
+  expect( static_cast<string_view>( middle ) == "23456", "slice(2, 5) has the wrong contents" );
+  expect( middle.size() == 5, "slice(2, 5) has the wrong size" );
+
+  // Slices of slices, and slices clamped to the end
+  expect( static_cast<string_view>( middle.slice( 1, 2 ) ) == "34", "slice of a slice has the wrong contents" );
+  expect( static_cast<string_view>( middle.slice( 3 ) ) == "56", "slice to end has the wrong contents" );
+  expect( static_cast<string_view>( whole.slice( 8, 100 ) ) == "89", "long slice should be clamped to the end" );
+  expect( whole.slice( 10 ).empty(), "slice at the end should be empty" );
+
+  // The slice views the same bytes, rather than a copy
+  expect( static_cast<string_view>( middle ).data() == static_cast<string_view>( whole ).data() + 2,
+          "slice should share its parent's storage" );
+
+  bool threw = false;
+  try {
+    (void)whole.slice( 11 );
+  } catch ( const out_of_range& ) {
+    threw = true;
+  }
+  expect( threw, "slice past the end should throw" );
+}
+
+void check_sharing()
+{
+  Buffer original { string( "hello" ) };
+  Buffer copy = original;
+  expect( static_cast<string_view>( copy ).data() == static_cast<string_view>( original ).data(),
+          "copies should share storage" );
+
+  // As before, a whole Buffer's string is shared by its copies
+  static_cast<string&>( original ).append( ", world" );
+  expect( static_cast<string_view>( copy ) == "hello, world", "copy should see a change to the shared string" );
+
+  // But writing through a slice gives it a string of its own
+  Buffer slice = original.slice( 7 );
+  static_cast<string&>( slice ) = "there";
+  expect( static_cast<string_view>( slice ) == "there", "slice should take the new contents" );
+  expect( static_cast<string_view>( original ) == "hello, world", "writing a slice mustn't touch its parent" );
+
+  // The storage outlives the Buffer it came from
+  Buffer tail = Buffer { string( "ephemeral data" ) }.slice( 10 );
+  expect( static_cast<string_view>( tail ) == "data", "slice should keep its storage alive" );
+
+  Buffer empty;
+  expect( empty.empty() and static_cast<string_view>( empty ).empty(), "default Buffer should be empty" );
+  static_cast<string&>( empty ) = "now full";
+  expect( empty.size() == 8, "default Buffer should be writable" );
+  expect( empty.release() == "now full", "release() should return the contents" );
+}
+
+// Parser::all_remaining hands back slices of its input instead of copies
+void check_parser()
+{
+  const vector<Buffer> input { string( "\x01\x02payload" ), string( " and more" ) };
+  Parser parser { input };
+  uint16_t x {};
+  parser.integer( x );
+  vector<Buffer> rest;
+  parser.all_remaining( rest );
+  expect( x == 0x0102 and rest.size() == 2, "Parser read the wrong values" );
+  expect( static_cast<string_view>( rest.front() ) == "payload", "all_remaining returned the wrong bytes" );
+  expect( static_cast<string_view>( rest.front() ).data() == static_cast<string_view>( input.front() ).data() + 2,
+          "all_remaining should slice its input, not copy it" );
+  expect( static_cast<string_view>( input.front() ).size() == 9, "all_remaining mustn't disturb its input" );
+
+  // Integers may straddle buffers, including empty ones
+  const vector<Buffer> split { string(), string( "\x01" ), string(), string( "\x02\x03" ), string( "\x04" ) };
+  Parser split_parser { split };
+  uint32_t y {};
+  split_parser.integer( y );
+  expect( y == 0x01020304 and not split_parser.has_error(), "Parser misread an integer split across buffers" );
+  split_parser.integer( x );
+  expect( split_parser.has_error(), "Parser should fail when the input runs out" );
+
+  // A zero-length string field at the very end of the input is fine
+  const vector<Buffer> exact { string( "\x05" ) };
+  Parser exact_parser { exact };
+  uint8_t z {};
+  exact_parser.integer( z );
+  string nothing;
+  exact_parser.string( nothing );
+  expect( z == 5 and not exact_parser.has_error(), "Parser should read an empty string at the end of input" );
+}
+
+// Copies dropped on other threads must leave the count consistent
+void check_threads()
+{
+  const Buffer shared { string( 1000, 'x' ) };
+  vector<thread> threads;
+  for ( int t = 0; t < 4; t++ ) {
+    threads.emplace_back( [&shared] {
+      for ( int i = 0; i < 10000; i++ ) {
+        const Buffer copy = shared.slice( i % 1000 );
+        if ( copy.size() != 1000 - static_cast<size_t>( i % 1000 ) ) {
+          abort();
+        }
+      }
+    } );
+  }
+  for ( auto& t : threads ) {
+    t.join();
+  }
+  expect( shared.size() == 1000 and static_cast<string_view>( shared ).front() == 'x',
+          "shared Buffer was damaged" );
+}
+
+int main()
+{
+  try {
+    check_slices();
+    check_sharing();
+    check_parser();
+#if not defined( MINNOW_SINGLE_THREADED )
+    check_threads();
+#endif
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
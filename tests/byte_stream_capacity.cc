@@ -97,6 +97,36 @@ int main()
       test.execute( BytesBuffered { 1 } );
     }
 
+    {
+      ByteStreamTestHarness test { "grow capacity", 2 };
+      test.execute( Push { "cat" } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( SetCapacity { 5 } );
+      test.execute( Capacity { 5 } );
+      test.execute( AvailableCapacity { 3 } );
+      test.execute( Push { "tle" } );
+      test.execute( BytesBuffered { 5 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "catle" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "shrink capacity", 5 };
+      test.execute( Push { "cat" } );
+      test.execute( SetCapacity { 2 } );
+      test.execute( Capacity { 2 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( BytesBuffered { 3 } );
+      test.execute( Push { "tle" } );
+      test.execute( BytesPushed { 3 } );
+      test.execute( Pop { 2 } );
+      test.execute( AvailableCapacity { 1 } );
+      test.execute( Push { "tle" } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( Peek { "tt" } );
+      test.execute( AvailableCapacity { 0 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
@@ -0,0 +1,171 @@
+#include "checksum.hh"
+#include "ipv4_header.hh"
+#include "random.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The original byte-at-a-time algorithm, as a reference
+uint16_t reference_checksum( uint32_t sum, const vector<string>& pieces )
+{
+  bool parity = false;
+  for ( const auto& piece : pieces ) {
+    for ( const uint8_t i : piece ) {
+      uint16_t val = i;
+      if ( not parity ) {
+        val <<= 8;
+      }
+      sum += val;
+      parity = !parity;
+    }
+  }
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + static_cast<uint16_t>( sum );
+  }
+  return ~sum;
+}
+
+uint16_t checksum( uint32_t sum, const vector<string>& pieces )
+{
+  InternetChecksum check { sum };
+  for ( const auto& piece : pieces ) {
+    check.add( piece );
+  }
+  return check.value();
+}
+
+void check_kernel( ChecksumKernel kernel, const string& name )
+{
+  InternetChecksum::use_kernel( kernel );
+
+  // Example from RFC 1071, section 3
+  const string rfc_example { "\x00\x01\xf2\x03\xf4\xf5\xf6\xf7", 8 };
+  if ( checksum( 0, { rfc_example } ) != static_cast<uint16_t>( ~0xddf2 ) ) {
+    throw runtime_error( name + " kernel got the RFC 1071 example wrong" );
+  }
+
+  auto rd = get_random_engine();
+  uniform_int_distribution<char> byte_dist;
+  uniform_int_distribution<size_t> len_dist { 0, 300 };
+  uniform_int_distribution<size_t> pieces_dist { 1, 5 };
+
+  for ( unsigned int i = 0; i < 20000; i++ ) {
+    // Random pieces of random (often odd) lengths, with some all-0xff data to exercise carries
+    const bool saturated = i % 10 == 0;
+    vector<string> pieces( pieces_dist( rd ) );
+    for ( auto& piece : pieces ) {
+      piece.resize( len_dist( rd ) );
+      for ( auto& c : piece ) {
+        c = saturated ? '\xff' : byte_dist( rd );
+      }
+    }
+    // Start part-way into a larger string, so the kernel sees unaligned data
+    pieces.front() = pieces.front().substr( min<size_t>( pieces.front().size(), i % 7 ) );
+
+    const uint32_t initial = static_cast<uint32_t>( rd() ) & 0x3ffff;
+    if ( checksum( initial, pieces ) != reference_checksum( initial, pieces ) ) {
+      throw runtime_error( name + " kernel disagreed with the byte-at-a-time checksum" );
+    }
+  }
+}
+
+// Incremental updates must agree with recomputing the checksum from scratch
+void check_incremental_update()
+{
+  auto rd = get_random_engine();
+  uniform_int_distribution<uint16_t> word_dist;
+
+  for ( unsigned int i = 0; i < 20000; i++ ) {
+    IPv4Header header;
+    header.len = word_dist( rd );
+    header.id = word_dist( rd );
+    header.ttl = static_cast<uint8_t>( i % 2 ? 1 + i % 255 : 1 + word_dist( rd ) % 255 );
+    header.proto = static_cast<uint8_t>( word_dist( rd ) );
+    header.src = rd();
+    header.dst = rd();
+    header.compute_checksum();
+
+    IPv4Header expected = header;
+    header.decrement_ttl();
+    expected.ttl--;
+    expected.compute_checksum();
+    if ( header.cksum != expected.cksum ) {
+      throw runtime_error( "IPv4Header::decrement_ttl() left the wrong checksum" );
+    }
+
+    const uint32_t new_src = i % 3 ? static_cast<uint32_t>( rd() ) : 0;
+    const uint32_t new_dst = i % 5 ? static_cast<uint32_t>( rd() ) : 0xffffffff;
+    header.set_src( new_src );
+    header.set_dst( new_dst );
+    expected.src = new_src;
+    expected.dst = new_dst;
+    expected.compute_checksum();
+    if ( header.cksum != expected.cksum ) {
+      throw runtime_error( "IPv4Header::set_src()/set_dst() left the wrong checksum" );
+    }
+  }
+}
+
+// IPv4Header::parse() validates the checksum over the raw bytes, including any options, unless told not to
+void check_header_validation()
+{
+  IPv4Header header;
+  header.len = 100;
+  header.src = 0x0a000001;
+  header.dst = 0x0a000002;
+  header.hlen = 6;
+  header.compute_checksum();
+
+  // compute_checksum() doesn't know about options, so add the option word to the checksum
+  const uint16_t option_word = 0x0102;
+  header.cksum = InternetChecksum::update( header.cksum, 0, option_word );
+  string raw;
+  for ( const auto& b : serialize( header ) ) {
+    raw.append( static_cast<string_view>( b ) );
+  }
+  raw.append( "\x01\x02\x00\x00", 4 );
+
+  // Split the header across buffers at an odd offset
+  if ( not parse( header, { raw.substr( 0, 7 ), raw.substr( 7 ) } ) or header.hlen != 6 ) {
+    throw runtime_error( "IPv4Header::parse() rejected a valid header with options" );
+  }
+
+  string corrupted = raw;
+  corrupted[IPv4Header::LENGTH] = 0x03;
+  if ( parse( header, { corrupted } ) ) {
+    throw runtime_error( "IPv4Header::parse() accepted a header with a bad checksum" );
+  }
+
+  const vector<Buffer> corrupted_input { corrupted };
+  Parser unverified { corrupted_input, false };
+  header.parse( unverified );
+  if ( unverified.has_error() ) {
+    throw runtime_error( "IPv4Header::parse() verified a checksum when told not to" );
+  }
+}
+
+int main()
+{
+  try {
+    check_header_validation();
+    check_incremental_update();
+    check_kernel( ChecksumKernel::Scalar, "scalar" );
+    if ( InternetChecksum::kernel_supported( ChecksumKernel::SSE2 ) ) {
+      check_kernel( ChecksumKernel::SSE2, "SSE2" );
+    }
+    if ( InternetChecksum::kernel_supported( ChecksumKernel::AVX2 ) ) {
+      check_kernel( ChecksumKernel::AVX2, "AVX2" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
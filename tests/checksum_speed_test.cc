@@ -0,0 +1,127 @@
+#include "checksum.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// The original byte-at-a-time algorithm
+uint16_t byte_at_a_time( string_view data )
+{
+  uint32_t sum = 0;
+  bool parity = false;
+  for ( const uint8_t i : data ) {
+    uint16_t val = i;
+    if ( not parity ) {
+      val <<= 8;
+    }
+    sum += val;
+    parity = !parity;
+  }
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + static_cast<uint16_t>( sum );
+  }
+  return ~sum;
+}
+
+uint16_t current( string_view data )
+{
+  InternetChecksum check;
+  check.add( data );
+  return check.value();
+}
+
+template<typename F>
+double throughput( const vector<string>& packets, const size_t rounds, F&& checksum, uint16_t& result )
+{
+  uint64_t bytes = 0;
+  uint16_t accumulate = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t r = 0; r < rounds; ++r ) {
+    for ( const auto& packet : packets ) {
+      // Keep the compiler from hoisting the checksum out of the loop or sinking it past the clock
+      accumulate ^= checksum( packet );
+      asm volatile( "" : "+r"( accumulate ) : : "memory" );
+      bytes += packet.size();
+    }
+  }
+  const auto stop_time = steady_clock::now();
+  result = accumulate;
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  return static_cast<double>( bytes ) / test_duration.count() / 1e9;
+}
+
+void speed_test( const string& name, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t packet_size,
+                 const size_t total_bytes )
+{
+  // A few hundred packets, so the data stays in cache and the kernels (not memory) are measured
+  default_random_engine rd { 1370 };
+  uniform_int_distribution<char> ud;
+  vector<string> packets( max<size_t>( 1, 256 * 1024 / packet_size ) );
+  for ( auto& packet : packets ) {
+    for ( size_t i = 0; i < packet_size; ++i ) {
+      packet.push_back( ud( rd ) );
+    }
+  }
+  const size_t rounds = max<size_t>( 1, total_bytes / ( packets.size() * packet_size ) );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  uint16_t reference_result {};
+  const double reference_gbps
+    = throughput( packets, max<size_t>( 1, rounds / 8 ), byte_at_a_time, reference_result );
+  cout << "Checksum of " << name << ": byte-at-a-time " << fixed << setprecision( 2 ) << reference_gbps << " GB/s";
+
+  for ( const auto& [kernel, kernel_name] : { pair { ChecksumKernel::Scalar, "64-bit" },
+                                              pair { ChecksumKernel::SSE2, "SSE2" },
+                                              pair { ChecksumKernel::AVX2, "AVX2" } } ) {
+    if ( not InternetChecksum::kernel_supported( kernel ) ) {
+      continue;
+    }
+    InternetChecksum::use_kernel( kernel );
+    for ( const auto& packet : packets ) {
+      if ( current( packet ) != byte_at_a_time( packet ) ) {
+        throw runtime_error( string( kernel_name ) + " checksum disagreed with the byte-at-a-time checksum" );
+      }
+    }
+    uint16_t result {};
+    const double gbps = throughput( packets, rounds, current, result );
+    cout << ", " << kernel_name << " " << gbps << " GB/s";
+    debug_output << "             Checksum " << name << " (" << kernel_name << "): " << fixed << setprecision( 2 )
+                 << gbps << " GB/s\n";
+    if ( gbps < reference_gbps ) {
+      throw runtime_error( string( kernel_name ) + " checksum was slower than byte-at-a-time." );
+    }
+  }
+  cout << ".\n";
+}
+
+void program_body()
+{
+  speed_test( "1500-byte packets", 1500, 1 << 30 );
+  speed_test( "64 KiB buffers", 65536, 1 << 30 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include "connection_table.hh"
+#include "flat_hash_map.hh"
+#include "random.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// Deliberately poor hash, so that long probe sequences (and wrap-around) get exercised
+struct ClusteringHash
+{
+  size_t operator()( uint32_t x ) const { return x % 61; }
+};
+
+void check_against_reference()
+{
+  auto rd = get_random_engine();
+  uniform_int_distribution<uint32_t> key_dist { 0, 2000 };
+  FlatHashMap<uint32_t, uint32_t, ClusteringHash> map;
+  unordered_map<uint32_t, uint32_t> reference;
+
+  for ( unsigned int i = 0; i < 100000; i++ ) {
+    const uint32_t key = key_dist( rd );
+    switch ( rd() % 3 ) {
+      case 0: {
+        const bool inserted = map.insert( key, i ).second;
+        if ( inserted != reference.insert( { key, i } ).second ) {
+          throw runtime_error( "FlatHashMap::insert disagreed with std::unordered_map" );
+        }
+      } break;
+      case 1:
+        if ( map.erase( key ) != static_cast<bool>( reference.erase( key ) ) ) {
+          throw runtime_error( "FlatHashMap::erase disagreed with std::unordered_map" );
+        }
+        break;
+      default: {
+        const uint32_t* value = map.find( key );
+        const auto it = reference.find( key );
+        if ( ( value == nullptr ) != ( it == reference.end() ) or ( value and *value != it->second ) ) {
+          throw runtime_error( "FlatHashMap::find disagreed with std::unordered_map" );
+        }
+      } break;
+    }
+    if ( map.size() != reference.size() ) {
+      throw runtime_error( "FlatHashMap::size disagreed with std::unordered_map" );
+    }
+  }
+}
+
+void check_connections()
+{
+  TCPConfig config;
+  const ConnectionKey a_key { 0x0a000001, 0x0a000002, 40000, 80 };
+  const ConnectionKey b_key { 0x0a000002, 0x0a000001, 80, 40000 };
+
+  ConnectionTable host_a;
+  ConnectionTable host_b;
+  for ( uint16_t port = 1; port < 1000; port++ ) {
+    host_b.open( { 0x0a000002, 0x0a000003, 80, port }, config ); // unrelated connections
+  }
+  TCPConnection& a = host_a.open( a_key, config );
+  TCPConnection& b = host_b.open( b_key, config );
+  if ( &host_b.open( b_key, config ) != &b or host_b.size() != 1000 ) {
+    throw runtime_error( "ConnectionTable::open created a duplicate connection" );
+  }
+
+  const string request = "GET / HTTP/1.1\r\n\r\n";
+  const string response( 5000, 'r' );
+  a.outbound_writer().push( request );
+  a.outbound_writer().close();
+  string got_request;
+  string got_response;
+  for ( unsigned int round = 0; round < 200 and ( a.active() or b.active() ); round++ ) {
+    while ( auto msg = a.maybe_send() ) {
+      host_b.demux( b_key, std::move( msg.value() ) );
+    }
+    while ( auto msg = b.maybe_send() ) {
+      host_a.demux( a_key, std::move( msg.value() ) );
+    }
+    string chunk;
+    read( b.inbound_reader(), b.inbound_reader().bytes_buffered(), chunk );
+    got_request += chunk;
+    read( a.inbound_reader(), a.inbound_reader().bytes_buffered(), chunk );
+    got_response += chunk;
+    if ( got_request == request and not b.outbound_writer().is_closed() ) {
+      b.outbound_writer().push( response );
+      b.outbound_writer().close();
+    }
+    host_a.tick( 10 );
+    host_b.tick( 10 );
+  }
+
+  if ( got_request != request or got_response != response ) {
+    throw runtime_error( "connections did not exchange the request and response" );
+  }
+  if ( a.active() or b.active() ) {
+    throw runtime_error( "connections still active after both streams finished" );
+  }
+  if ( host_a.demux( b_key, {} ) ) {
+    throw runtime_error( "ConnectionTable::demux delivered a segment for an unknown 4-tuple" );
+  }
+  if ( not host_b.close( b_key ) or host_b.find( b_key ) or host_b.size() != 999 ) {
+    throw runtime_error( "ConnectionTable::close did not remove the connection" );
+  }
+}
+
+int main()
+{
+  try {
+    check_against_reference();
+    check_connections();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include "connection_table.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+void speed_test( const size_t num_connections, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t num_segments,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed )    // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<uint32_t> ip_dist;
+  uniform_int_distribution<uint16_t> port_dist { 1024 };
+
+  // Open the connections
+  vector<ConnectionKey> keys;
+  keys.reserve( num_connections );
+  for ( size_t i = 0; i < num_connections; ++i ) {
+    keys.push_back( { ip_dist( rd ), ip_dist( rd ), port_dist( rd ), 443 } );
+  }
+
+  TCPConfig config;
+  config.recv_capacity = 4096;
+  config.send_capacity = 4096;
+  const size_t heap_before = mallinfo2().uordblks;
+  ConnectionTable table { num_connections };
+  for ( const auto& key : keys ) {
+    table.open( key, config );
+  }
+  const size_t heap_after = mallinfo2().uordblks;
+
+  // Choose which connection each incoming segment belongs to
+  vector<ConnectionKey> arrivals;
+  arrivals.reserve( num_segments );
+  uniform_int_distribution<size_t> conn_dist { 0, num_connections - 1 };
+  for ( size_t i = 0; i < num_segments; ++i ) {
+    arrivals.push_back( keys[conn_dist( rd )] );
+  }
+
+  const auto start_time = steady_clock::now();
+  size_t delivered = 0;
+  for ( const auto& key : arrivals ) {
+    delivered += table.demux( key, {} );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( delivered != num_segments ) {
+    throw runtime_error( "ConnectionTable failed to find an open connection" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto segments_per_second = static_cast<double>( num_segments ) / test_duration.count();
+  auto ns_per_segment = 1e9 / segments_per_second;
+  auto bytes_per_connection
+    = static_cast<double>( heap_after - heap_before ) / static_cast<double>( num_connections );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "ConnectionTable with " << num_connections << " connections (" << fixed << setprecision( 0 )
+       << bytes_per_connection << " heap bytes each) demuxed " << setprecision( 2 ) << segments_per_second / 1e6
+       << " M segments/s (" << ns_per_segment << " ns/segment).\n";
+
+  debug_output << "             ConnectionTable demux rate: " << fixed << setprecision( 2 )
+               << segments_per_second / 1e6 << " M segments/s\n";
+
+  if ( segments_per_second < 1e5 ) {
+    throw runtime_error( "ConnectionTable did not meet minimum demux rate of 100k segments/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 100000, 2000000, 1370 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// A discrete-event scheduler with a virtual clock.
+//
+// Events are callbacks scheduled for a point in virtual time (in microseconds). run() repeatedly
+// pops the earliest event, jumps the clock straight to it and runs it, so idle stretches cost
+// nothing. Events scheduled for the same time run in the order they were scheduled.
+class EventSimulator
+{
+  struct Event
+  {
+    uint64_t at_us;
+    uint64_t order;
+    std::function<void()> action;
+
+    bool operator>( const Event& other ) const
+    {
+      return at_us != other.at_us ? at_us > other.at_us : order > other.order;
+    }
+  };
+
+  uint64_t now_us_ {};
+  uint64_t next_order_ {};
+  uint64_t events_run_ {};
+  std::vector<Event> events_ {}; // a min-heap (std::greater), earliest event at the front
+
+public:
+  uint64_t now_us() const { return now_us_; }
+  uint64_t now_ms() const { return now_us_ / 1000; }
+
+  // Run `action` at virtual time `at_us` (or now, if that is already in the past)
+  void schedule_at( uint64_t at_us, std::function<void()> action )
+  {
+    events_.push_back( { std::max( at_us, now_us_ ), next_order_++, std::move( action ) } );
+    std::push_heap( events_.begin(), events_.end(), std::greater<> {} );
+  }
+
+  // Run `action` `delay_us` microseconds from now
+  void schedule_in( uint64_t delay_us, std::function<void()> action )
+  {
+    schedule_at( now_us_ + delay_us, std::move( action ) );
+  }
+
+  // Run the earliest event. Returns false if there was nothing left to run.
+  bool run_one()
+  {
+    if ( events_.empty() ) {
+      return false;
+    }
+    std::pop_heap( events_.begin(), events_.end(), std::greater<> {} );
+    const std::function<void()> action = std::move( events_.back().action );
+    now_us_ = events_.back().at_us;
+    events_.pop_back();
+    events_run_++;
+    action();
+    return true;
+  }
+
+  // Run events until none are left, or the next one is later than `end_us`
+  void run_until( uint64_t end_us )
+  {
+    while ( not events_.empty() and events_.front().at_us <= end_us ) {
+      run_one();
+    }
+    now_us_ = std::max( now_us_, end_us );
+  }
+
+  // Run events until none are left
+  void run()
+  {
+    while ( run_one() ) {}
+  }
+
+  size_t events_pending() const { return events_.size(); }
+  uint64_t events_run() const { return events_run_; }
+};
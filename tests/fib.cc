@@ -0,0 +1,153 @@
+#include "fib.hh"
+#include "address.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+using namespace std;
+
+uint32_t ip( const string& str )
+{
+  return Address { str }.ipv4_numeric();
+}
+
+void expect_hop( const Fib& fib, const string& address, const uint16_t expected )
+{
+  const uint16_t hop = fib.lookup( ip( address ) );
+  if ( hop != expected ) {
+    throw runtime_error( address + " went to next hop " + to_string( hop ) + " instead of "
+                         + to_string( expected ) );
+  }
+}
+
+template<class Exception, class Function>
+void expect_throw( const Function& f, const string& what )
+{
+  try {
+    f();
+  } catch ( const Exception& ) {
+    return;
+  }
+  throw runtime_error( what );
+}
+
+void check_longest_match()
+{
+  Fib fib;
+  expect_hop( fib, "1.2.3.4", Fib::NO_ROUTE );
+
+  fib.insert( ip( "10.0.0.0" ), 8, 1 );
+  fib.insert( ip( "10.1.0.0" ), 16, 2 );
+  fib.insert( ip( "10.1.2.0" ), 24, 3 );
+  fib.insert( ip( "10.1.2.128" ), 25, 4 );
+  fib.insert( ip( "10.1.2.200" ), 32, 5 );
+  fib.insert( ip( "10.1.3.64" ), 26, 6 );
+  expect_hop( fib, "10.1.2.3", Fib::NO_ROUTE ); // not built yet
+  fib.build();
+
+  expect_hop( fib, "9.255.255.255", Fib::NO_ROUTE );
+  expect_hop( fib, "10.0.0.0", 1 );
+  expect_hop( fib, "10.255.255.255", 1 );
+  expect_hop( fib, "10.1.0.1", 2 );
+  expect_hop( fib, "10.1.2.0", 3 );
+  expect_hop( fib, "10.1.2.127", 3 );
+  expect_hop( fib, "10.1.2.128", 4 );
+  expect_hop( fib, "10.1.2.199", 4 );
+  expect_hop( fib, "10.1.2.200", 5 );
+  expect_hop( fib, "10.1.2.201", 4 );
+  expect_hop( fib, "10.1.3.63", 2 ); // the rest of a /24 split by a longer prefix keeps the shorter match
+  expect_hop( fib, "10.1.3.64", 6 );
+  expect_hop( fib, "10.1.3.128", 2 );
+  expect_hop( fib, "11.0.0.0", Fib::NO_ROUTE );
+  if ( fib.tbl8_groups() != 2 ) {
+    throw runtime_error( "expected a tbl8 group for each of 10.1.2.0/24 and 10.1.3.0/24" );
+  }
+
+  // A default route, a replaced route, and a prefix with host bits set
+  fib.insert( 0, 0, 7 );
+  fib.insert( ip( "10.1.0.0" ), 16, 8 );
+  fib.insert( ip( "192.168.77.77" ), 16, 9 );
+  fib.build();
+  expect_hop( fib, "11.0.0.0", 7 );
+  expect_hop( fib, "10.1.0.1", 8 );
+  expect_hop( fib, "10.1.3.63", 8 );
+  expect_hop( fib, "10.1.2.200", 5 );
+  expect_hop( fib, "192.168.0.1", 9 );
+  expect_hop( fib, "192.169.0.1", 7 );
+  if ( fib.size() != 8 ) {
+    throw runtime_error( "replacing a route should not add one" );
+  }
+}
+
+// Once built, routes added later take effect immediately, the same as if the table had been built with them
+void check_incremental()
+{
+  Fib fib;
+  fib.insert( ip( "10.0.0.0" ), 8, 1 );
+  fib.insert( ip( "10.1.2.128" ), 25, 2 );
+  fib.build();
+
+  fib.insert( ip( "10.1.0.0" ), 16, 3 ); // shorter than an existing /25 in the same /24
+  fib.insert( ip( "10.1.2.192" ), 26, 4 );
+  fib.insert( ip( "10.1.3.0" ), 24, 5 );
+  fib.insert( ip( "10.1.3.7" ), 32, 6 ); // splits a /24 that had only a tbl24 entry
+  fib.insert( ip( "10.1.2.128" ), 25, 7 ); // replaced
+  expect_hop( fib, "10.2.0.0", 1 );
+  expect_hop( fib, "10.1.0.1", 3 );
+  expect_hop( fib, "10.1.2.1", 3 );
+  expect_hop( fib, "10.1.2.129", 7 );
+  expect_hop( fib, "10.1.2.193", 4 );
+  expect_hop( fib, "10.1.3.6", 5 );
+  expect_hop( fib, "10.1.3.7", 6 );
+
+  fib.insert( ip( "10.0.0.0" ), 8, 8 ); // replaced, but only where no longer prefix matches
+  fib.insert( 0, 0, 9 );
+  expect_hop( fib, "10.2.0.0", 8 );
+  expect_hop( fib, "10.1.2.1", 3 );
+  expect_hop( fib, "10.1.3.7", 6 );
+  expect_hop( fib, "11.0.0.0", 9 );
+
+  Fib rebuilt;
+  for ( const auto& [prefix, length, hop] : { tuple { "10.0.0.0", 8, 8 },
+                                              tuple { "10.1.2.128", 25, 7 },
+                                              tuple { "10.1.0.0", 16, 3 },
+                                              tuple { "10.1.2.192", 26, 4 },
+                                              tuple { "10.1.3.0", 24, 5 },
+                                              tuple { "10.1.3.7", 32, 6 },
+                                              tuple { "0.0.0.0", 0, 9 } } ) {
+    rebuilt.insert( ip( prefix ), length, hop );
+  }
+  rebuilt.build();
+  for ( uint32_t address = ip( "10.1.0.0" ); address < ip( "10.1.4.0" ); address++ ) {
+    if ( fib.lookup( address ) != rebuilt.lookup( address ) ) {
+      throw runtime_error( "updating a built Fib disagreed with building it from scratch at "
+                           + to_string( address ) );
+    }
+  }
+}
+
+void check_bad_routes()
+{
+  Fib fib;
+  expect_throw<invalid_argument>( [&] { fib.insert( 0, 33, 1 ); }, "a /33 should be rejected" );
+  expect_throw<invalid_argument>( [&] { fib.insert( 0, 8, Fib::NO_ROUTE ); }, "next hop 0 should be rejected" );
+  expect_throw<invalid_argument>( [&] { fib.insert( 0, 8, Fib::MAX_NEXT_HOP + 1 ); },
+                                  "an oversized next hop should be rejected" );
+}
+
+int main()
+{
+  try {
+    check_longest_match();
+    check_incremental();
+    check_bad_routes();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+#include "fib.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+struct Prefix
+{
+  uint32_t prefix;
+  uint8_t length;
+  uint16_t next_hop;
+};
+
+uint32_t mask( const uint8_t length )
+{
+  return length == 0 ? 0 : ~( ( uint64_t { 1 } << ( 32 - length ) ) - 1 );
+}
+
+// Prefixes shaped like a full Internet routing table: mostly /24s, then /22s and /23s, a tail of shorter
+// prefixes, and (unlike a real table, to exercise tbl8) some longer ones, with a few hundred next hops
+vector<Prefix> synthetic_table( const size_t count, default_random_engine& rd )
+{
+  // percentage of prefixes with each length
+  array<double, 33> weights {};
+  weights[8] = 0.02;
+  for ( size_t length = 9; length <= 15; length++ ) {
+    weights[length] = 0.1;
+  }
+  weights[16] = 1.3;
+  weights[17] = 0.8;
+  weights[18] = 1.3;
+  weights[19] = 2.5;
+  weights[20] = 4;
+  weights[21] = 5;
+  weights[22] = 11;
+  weights[23] = 10;
+  weights[24] = 60;
+  for ( size_t length = 25; length <= 32; length++ ) {
+    weights[length] = 0.2;
+  }
+  discrete_distribution<int> length_dist { weights.begin(), weights.end() };
+  uniform_int_distribution<uint32_t> address_dist;
+  uniform_int_distribution<uint16_t> next_hop_dist { 1, 400 };
+
+  vector<Prefix> table;
+  table.reserve( count );
+  for ( size_t i = 0; i < count; i++ ) {
+    const auto length = static_cast<uint8_t>( length_dist( rd ) );
+    table.push_back( { address_dist( rd ) & mask( length ), length, next_hop_dist( rd ) } );
+  }
+  return table;
+}
+
+// The same longest match, the slow way
+class ReferenceTable
+{
+  array<unordered_map<uint32_t, uint16_t>, 33> by_length_ {};
+
+public:
+  explicit ReferenceTable( const vector<Prefix>& table )
+  {
+    for ( const auto& p : table ) {
+      by_length_[p.length][p.prefix] = p.next_hop;
+    }
+  }
+
+  uint16_t lookup( const uint32_t address ) const
+  {
+    for ( int length = 32; length >= 0; length-- ) {
+      const auto& routes = by_length_[length];
+      if ( const auto it = routes.find( address & mask( length ) ); it != routes.end() ) {
+        return it->second;
+      }
+    }
+    return Fib::NO_ROUTE;
+  }
+};
+
+void speed_test( const size_t routes, const size_t lookups )
+{
+  default_random_engine rd { 144 }; // NOLINT(*-msc51-cpp)
+  const vector<Prefix> table = synthetic_table( routes, rd );
+
+  Fib fib;
+  const auto build_start = steady_clock::now();
+  for ( const auto& p : table ) {
+    fib.insert( p.prefix, p.length, p.next_hop );
+  }
+  fib.build();
+  const auto build_stop = steady_clock::now();
+
+  // Half the destinations fall inside a routed prefix (often a long one), half are uniformly random
+  uniform_int_distribution<uint32_t> address_dist;
+  vector<uint32_t> addresses;
+  addresses.reserve( 1 << 20 );
+  for ( size_t i = 0; i < addresses.capacity(); i++ ) {
+    const uint32_t random = address_dist( rd );
+    if ( i % 2 ) {
+      addresses.push_back( random );
+    } else {
+      const Prefix& p = table[random % table.size()];
+      addresses.push_back( p.prefix | ( address_dist( rd ) & ~mask( p.length ) ) );
+    }
+  }
+
+  const ReferenceTable reference { table };
+  for ( size_t i = 0; i < 100000; i++ ) {
+    if ( fib.lookup( addresses[i] ) != reference.lookup( addresses[i] ) ) {
+      throw runtime_error( "Fib disagreed with the reference longest match for address "
+                           + to_string( addresses[i] ) );
+    }
+  }
+
+  uint64_t checksum = 0;
+  const auto lookup_start = steady_clock::now();
+  for ( size_t i = 0; i < lookups; i++ ) {
+    checksum += fib.lookup( addresses[i & ( addresses.size() - 1 )] );
+  }
+  const auto lookup_stop = steady_clock::now();
+
+  if ( checksum == 0 ) {
+    throw runtime_error( "no lookup matched a route" );
+  }
+
+  // Route changes once the table is built: each one only rewrites the entries its prefix covers
+  const vector<Prefix> updates = synthetic_table( 10000, rd );
+  const auto update_start = steady_clock::now();
+  for ( const auto& p : updates ) {
+    fib.insert( p.prefix, p.length, p.next_hop );
+  }
+  const auto update_stop = steady_clock::now();
+
+  vector<Prefix> updated_table = table;
+  updated_table.insert( updated_table.end(), updates.begin(), updates.end() );
+  const ReferenceTable updated_reference { updated_table };
+  for ( size_t i = 0; i < 100000; i++ ) {
+    if ( fib.lookup( addresses[i] ) != updated_reference.lookup( addresses[i] ) ) {
+      throw runtime_error( "updated Fib disagreed with the reference longest match for address "
+                           + to_string( addresses[i] ) );
+    }
+  }
+
+  const double build_ms = duration_cast<duration<double, milli>>( build_stop - build_start ).count();
+  const double ns_per_lookup
+    = duration_cast<duration<double, nano>>( lookup_stop - lookup_start ).count() / static_cast<double>( lookups );
+  const double us_per_update = duration_cast<duration<double, micro>>( update_stop - update_start ).count()
+                               / static_cast<double>( updates.size() );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Fib with " << fib.size() << " prefixes (" << fib.tbl8_groups() << " tbl8 groups): built in " << fixed
+       << setprecision( 1 ) << build_ms << " ms, " << setprecision( 2 ) << ns_per_lookup << " ns per lookup ("
+       << setprecision( 1 ) << 1000 / ns_per_lookup << " M lookups/s), " << setprecision( 2 ) << us_per_update
+       << " us per route update.\n";
+
+  debug_output << "             Fib (" << fib.size() << " prefixes): " << fixed << setprecision( 2 )
+               << 1000 / ns_per_lookup << " Mlookups/s, " << ns_per_lookup << " ns/lookup\n";
+
+  if ( ns_per_lookup > 1000 ) {
+    throw runtime_error( "Fib did not meet minimum rate of 1M lookups/s." );
+  }
+  if ( us_per_update > 1000 ) {
+    throw runtime_error( "Fib did not meet minimum rate of 1k route updates/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 1'000'000, 50'000'000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
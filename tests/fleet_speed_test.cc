@@ -0,0 +1,220 @@
+#include "event_simulator.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr uint64_t NO_TIMER = numeric_limits<uint64_t>::max();
+
+// One direction of a connection: a TCPSender and the TCPReceiver it talks to
+struct Flow
+{
+  explicit Flow( const TCPConfig& config )
+    : outbound( config.send_capacity )
+    , sender( config.rt_timeout, config.fixed_isn )
+    , inbound( config.recv_capacity )
+    , receiver( config )
+  {}
+
+  ByteStream outbound;
+  TCPSender sender;
+  Reassembler reassembler {};
+  ByteStream inbound;
+  TCPReceiver receiver;
+
+  uint64_t last_tick_ms {};          // virtual time the sender and receiver were last ticked to
+  uint64_t timer_at_us { NO_TIMER }; // when the pending deadline event fires (stale events are ignored)
+  uint64_t bytes_written {};
+};
+
+// Many flows sharing one virtual clock. Each flow is only touched when something happens to it: the
+// application writes, a segment or ACK arrives, or one of its timers comes due.
+class Fleet
+{
+  EventSimulator sim_ {};
+  vector<unique_ptr<Flow>> flows_ {};
+  uint64_t delay_us_;
+  uint64_t tick_calls_ {};
+
+  // Bring a flow's clocks up to the present
+  void catch_up( Flow& flow )
+  {
+    const uint64_t now_ms = sim_.now_ms();
+    if ( now_ms > flow.last_tick_ms ) {
+      flow.sender.tick( now_ms - flow.last_tick_ms );
+      flow.receiver.tick( now_ms - flow.last_tick_ms );
+      flow.last_tick_ms = now_ms;
+      tick_calls_++;
+    }
+  }
+
+  // Send whatever is ready, then make sure an event is scheduled for the flow's next deadline
+  void service( size_t id )
+  {
+    Flow& flow = *flows_[id];
+    flow.sender.push( flow.outbound.reader() );
+    while ( auto seg = flow.sender.maybe_send() ) {
+      sim_.schedule_in( delay_us_, [this, id, seg = std::move( seg.value() )] { segment_arrives( id, seg ); } );
+    }
+    if ( auto ack = flow.receiver.maybe_send( flow.inbound.writer() ) ) {
+      sim_.schedule_in( delay_us_, [this, id, ack = ack.value()] { ack_arrives( id, ack ); } );
+    }
+
+    optional<uint64_t> deadline = flow.sender.ms_until_timeout();
+    if ( const auto ack_deadline = flow.receiver.ms_until_ack() ) {
+      deadline = min( deadline.value_or( NO_TIMER ), ack_deadline.value() );
+    }
+    if ( not deadline ) {
+      return;
+    }
+    const uint64_t at_us = ( flow.last_tick_ms + deadline.value() ) * 1000;
+    if ( flow.timer_at_us <= at_us ) {
+      return; // an earlier event will re-check
+    }
+    flow.timer_at_us = at_us;
+    sim_.schedule_at( at_us, [this, id, at_us] {
+      Flow& f = *flows_[id];
+      if ( f.timer_at_us == at_us ) {
+        f.timer_at_us = NO_TIMER;
+        catch_up( f );
+        service( id );
+      }
+    } );
+  }
+
+  void segment_arrives( size_t id, const TCPSenderMessage& seg )
+  {
+    Flow& flow = *flows_[id];
+    catch_up( flow );
+    flow.receiver.receive( seg, flow.reassembler, flow.inbound.writer() );
+    flow.inbound.reader().pop( flow.inbound.reader().bytes_buffered() );
+    service( id );
+  }
+
+  void ack_arrives( size_t id, const TCPReceiverMessage& ack )
+  {
+    Flow& flow = *flows_[id];
+    catch_up( flow );
+    flow.sender.receive( ack );
+    service( id );
+  }
+
+  void app_writes( size_t id, const string& data, uint64_t interval_us, uint64_t stop_us )
+  {
+    Flow& flow = *flows_[id];
+    catch_up( flow );
+    if ( flow.outbound.writer().available_capacity() >= data.size() ) {
+      flow.outbound.writer().push( data );
+      flow.bytes_written += data.size();
+    }
+    service( id );
+    if ( sim_.now_us() + interval_us < stop_us ) {
+      sim_.schedule_in( interval_us, [=, this, &data] { app_writes( id, data, interval_us, stop_us ); } );
+    }
+  }
+
+public:
+  Fleet( const TCPConfig& config, size_t num_flows, uint64_t delay_us ) : delay_us_( delay_us )
+  {
+    flows_.reserve( num_flows );
+    for ( size_t i = 0; i < num_flows; ++i ) {
+      flows_.push_back( make_unique<Flow>( config ) );
+    }
+  }
+
+  // Every flow writes `data` once per interval (with staggered start times) until `stop_us`,
+  // then the simulation runs until all the data has been delivered and acknowledged
+  void run( const string& data, uint64_t interval_us, uint64_t stop_us, size_t random_seed )
+  {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<uint64_t> start_dist { 0, interval_us - 1 };
+    for ( size_t id = 0; id < flows_.size(); ++id ) {
+      sim_.schedule_at( start_dist( rd ), [=, this, &data] { app_writes( id, data, interval_us, stop_us ); } );
+    }
+    sim_.run();
+  }
+
+  void check() const
+  {
+    for ( const auto& flow : flows_ ) {
+      if ( flow->inbound.writer().bytes_pushed() != flow->bytes_written
+           or flow->sender.sequence_numbers_in_flight() ) {
+        throw runtime_error( "fleet simulation finished with data still undelivered" );
+      }
+    }
+  }
+
+  uint64_t events_run() const { return sim_.events_run(); }
+  uint64_t tick_calls() const { return tick_calls_; }
+  uint64_t now_ms() const { return sim_.now_ms(); }
+};
+
+void speed_test( const size_t num_flows,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const uint64_t seconds,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  constexpr uint64_t interval_us = 100'000; // each flow writes 10 times per second
+  constexpr uint64_t delay_us = 10'000;     // 10 ms one-way delay
+  const string data( 800, 'x' );
+
+  TCPConfig config;
+  config.send_capacity = 4096;
+  config.recv_capacity = 4096;
+  config.fixed_isn = Wrap32 { static_cast<uint32_t>( random_seed ) };
+
+  Fleet fleet { config, num_flows, delay_us };
+  const auto start_time = steady_clock::now();
+  fleet.run( data, interval_us, seconds * 1'000'000, random_seed );
+  const auto stop_time = steady_clock::now();
+  fleet.check();
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto connection_seconds = static_cast<double>( num_flows ) * static_cast<double>( fleet.now_ms() ) / 1000;
+  const double us_per_connection_second = test_duration.count() * 1e6 / connection_seconds;
+  const double naive_ticks = static_cast<double>( num_flows ) * static_cast<double>( fleet.now_ms() );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Fleet of " << num_flows << " connections over " << fleet.now_ms()
+       << " virtual ms: " << fleet.events_run() << " events, " << fleet.tick_calls() << " tick() calls (vs. "
+       << fixed << setprecision( 0 ) << naive_ticks << " at 1 ms granularity).\n";
+  cout << "CPU cost: " << setprecision( 2 ) << us_per_connection_second << " us per connection-second (about "
+       << setprecision( 0 ) << 1e6 / us_per_connection_second << " connections per core).\n";
+
+  debug_output << "             Fleet simulation: " << fixed << setprecision( 2 ) << us_per_connection_second
+               << " us per connection-second\n";
+
+  if ( us_per_connection_second > 1000 ) {
+    throw runtime_error( "Fleet simulation did not sustain 1000 connections per core." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 10000, 4, 1370 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// The header's bytes as one contiguous buffer, as they would arrive off the wire
+template<class T>
+string wire_format( const T& header )
+{
+  string wire;
+  for ( const auto& b : serialize( header ) ) {
+    wire.append( static_cast<string_view>( b ) );
+  }
+  return wire;
+}
+
+template<class T>
+void speed_test( const string& name, const T& header, const size_t repetitions )
+{
+  const vector<Buffer> input { wire_format( header ) };
+
+  T parsed {};
+  size_t ok = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < repetitions; ++i ) {
+    ok += parse( parsed, input );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( ok != repetitions or wire_format( parsed ) != wire_format( header ) ) {
+    throw runtime_error( name + " failed to parse its own output" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const double rate = static_cast<double>( repetitions ) / test_duration.count();
+  const double ns_per_header = 1e9 / rate;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << name << " (" << input.front().size() << " bytes): " << fixed << setprecision( 2 ) << rate / 1e6
+       << " M parsed/s (" << setprecision( 1 ) << ns_per_header << " ns/header).\n";
+
+  debug_output << "             " << name << ": " << fixed << setprecision( 2 ) << rate / 1e6
+               << " M parsed/s\n";
+
+  if ( rate < 1e5 ) {
+    throw runtime_error( name + " parsing did not meet minimum rate of 100k headers/s." );
+  }
+}
+
+void program_body()
+{
+  constexpr size_t repetitions = 2000000;
+
+  EthernetHeader ethernet {};
+  ethernet.dst = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+  ethernet.src = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+  ethernet.type = EthernetHeader::TYPE_IPv4;
+  speed_test( "EthernetHeader", ethernet, repetitions );
+
+  IPv4Header ip;
+  ip.len = 1500;
+  ip.id = 1234;
+  ip.src = 0x0a000001;
+  ip.dst = 0xc0a80001;
+  ip.compute_checksum();
+  speed_test( "IPv4Header", ip, repetitions );
+
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REQUEST;
+  arp.sender_ethernet_address = ethernet.src;
+  arp.sender_ip_address = ip.src;
+  arp.target_ip_address = ip.dst;
+  speed_test( "ARPMessage", arp, repetitions );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
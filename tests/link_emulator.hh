@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Properties of an emulated one-way link
+struct LinkConfig
+{
+  uint64_t bandwidth_bps = 0; // serialization rate (0 means infinitely fast)
+  uint64_t delay_us = 0;      // one-way propagation delay
+  uint64_t jitter_us = 0;     // extra delay, uniform in [0, jitter_us] (packets still arrive in order)
+
+  double loss = 0; // independent (Bernoulli) loss probability
+
+  // Bursty loss (Gilbert-Elliott): each packet may move the link between a "good" state, where only
+  // `loss` applies, and a "bad" state, where packets are lost with probability `burst_loss`.
+  double burst_enter = 0; // P(good -> bad)
+  double burst_exit = 1;  // P(bad -> good)
+  double burst_loss = 0;
+
+  double reorder = 0;      // probability that a packet is held back and overtaken by later ones
+  uint64_t reorder_us = 0; // how long a reordered packet is held back
+  size_t queue_limit = 0;  // packets waiting to be serialized before tail drop (0 means unlimited)
+  uint64_t seed = 0;       // seed for all random choices, so every run is reproducible
+};
+
+struct LinkStats
+{
+  uint64_t sent {};
+  uint64_t delivered {};
+  uint64_t dropped_loss {};
+  uint64_t dropped_queue {};
+  uint64_t reordered {};
+  uint64_t bytes_delivered {};
+};
+
+// A deterministic in-process link that carries objects of type T (e.g. TCPMessage or EthernetFrame)
+// from one endpoint to another.
+//
+// Time is a virtual clock in microseconds that only moves when the caller calls advance(). Each
+// packet waits for the link to finish serializing the packets ahead of it, then propagates for
+// delay (+ jitter, + reordering hold-back) before it can be received.
+template<typename T>
+class LinkEmulator
+{
+  struct InFlight
+  {
+    uint64_t arrival_us;
+    uint64_t order; // tie-breaker, so packets with equal arrival times stay FIFO
+    size_t bytes;
+    T item;
+
+    bool operator>( const InFlight& other ) const
+    {
+      return arrival_us != other.arrival_us ? arrival_us > other.arrival_us : order > other.order;
+    }
+  };
+
+  LinkConfig config_;
+  std::default_random_engine rd_;
+  std::uniform_real_distribution<double> coin_ { 0.0, 1.0 };
+
+  uint64_t now_us_ {};
+  uint64_t busy_until_us_ {};   // when the transmitter finishes the last queued packet
+  uint64_t last_arrival_us_ {}; // latest in-order arrival time
+  uint64_t next_order_ {};
+  bool bad_state_ {};
+  std::deque<uint64_t> serialization_end_ {}; // finish times of packets still waiting to be sent
+  std::vector<InFlight> in_flight_ {}; // a min-heap (std::greater), earliest arrival at the front
+  LinkStats stats_ {};
+
+  bool lost()
+  {
+    if ( config_.burst_enter > 0 ) {
+      if ( bad_state_ ? coin_( rd_ ) < config_.burst_exit : coin_( rd_ ) < config_.burst_enter ) {
+        bad_state_ = not bad_state_;
+      }
+      if ( bad_state_ and coin_( rd_ ) < config_.burst_loss ) {
+        return true;
+      }
+    }
+    return config_.loss > 0 and coin_( rd_ ) < config_.loss;
+  }
+
+public:
+  explicit LinkEmulator( const LinkConfig& config ) : config_( config ), rd_( config.seed ) {}
+
+  // Offer a packet of `bytes` bytes (on the wire) to the link at the current time
+  void send( T item, size_t bytes )
+  {
+    stats_.sent++;
+
+    while ( not serialization_end_.empty() and serialization_end_.front() <= now_us_ ) {
+      serialization_end_.pop_front();
+    }
+    if ( config_.queue_limit and serialization_end_.size() >= config_.queue_limit ) {
+      stats_.dropped_queue++;
+      return;
+    }
+
+    const uint64_t tx_start = std::max( now_us_, busy_until_us_ );
+    const uint64_t tx_time = config_.bandwidth_bps ? bytes * 8 * 1000000 / config_.bandwidth_bps : 0;
+    busy_until_us_ = tx_start + tx_time;
+    serialization_end_.push_back( busy_until_us_ );
+
+    // A lost packet still used up its share of the link
+    if ( lost() ) {
+      stats_.dropped_loss++;
+      return;
+    }
+
+    uint64_t arrival = busy_until_us_ + config_.delay_us;
+    if ( config_.jitter_us ) {
+      arrival += std::uniform_int_distribution<uint64_t> { 0, config_.jitter_us }( rd_ );
+    }
+    if ( config_.reorder > 0 and coin_( rd_ ) < config_.reorder ) {
+      arrival += config_.reorder_us;
+      stats_.reordered++;
+    } else {
+      arrival = std::max( arrival, last_arrival_us_ );
+      last_arrival_us_ = arrival;
+    }
+    in_flight_.push_back( { arrival, next_order_++, bytes, std::move( item ) } );
+    std::push_heap( in_flight_.begin(), in_flight_.end(), std::greater<> {} );
+  }
+
+  // Move the clock forward
+  void advance( uint64_t us ) { now_us_ += us; }
+
+  // The next packet that has arrived by now (or empty optional if there is none)
+  std::optional<T> receive()
+  {
+    if ( in_flight_.empty() or in_flight_.front().arrival_us > now_us_ ) {
+      return {};
+    }
+    std::pop_heap( in_flight_.begin(), in_flight_.end(), std::greater<> {} );
+    std::optional<T> item { std::move( in_flight_.back().item ) };
+    stats_.delivered++;
+    stats_.bytes_delivered += in_flight_.back().bytes;
+    in_flight_.pop_back();
+    return item;
+  }
+
+  // When the next packet will arrive (or empty optional if nothing is in flight)
+  std::optional<uint64_t> next_arrival_us() const
+  {
+    if ( in_flight_.empty() ) {
+      return {};
+    }
+    return in_flight_.front().arrival_us;
+  }
+
+  // Packets still waiting for (or in the middle of) serialization, like the occupancy of a NIC's TX ring
+  size_t backlog()
+  {
+    while ( not serialization_end_.empty() and serialization_end_.front() <= now_us_ ) {
+      serialization_end_.pop_front();
+    }
+    return serialization_end_.size();
+  }
+
+  uint64_t now_us() const { return now_us_; }
+  size_t packets_in_flight() const { return in_flight_.size(); }
+  const LinkStats& stats() const { return stats_; }
+};
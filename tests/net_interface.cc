@@ -320,6 +320,306 @@ int main()
         serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
       test.execute( ExpectNoFrame {} );
     }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth1 = random_private_ethernet_address();
+      const EthernetAddress remote_eth2 = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "pending datagrams wait for their own next hop", local_eth, Address( "10.0.0.1", 0 ) };
+
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+      const auto datagram2 = make_datagram( "10.0.0.1", "4.10.4.10" );
+      const auto datagram3 = make_datagram( "10.0.0.1", "144.144.144.144" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.19", 0 ) } );
+      test.execute( SendDatagram { datagram3, Address( "10.0.0.5", 0 ) } );
+
+      // one ARP request per next hop
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.19" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // the second next hop answers first, and releases only its own datagram
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth2,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth2, "10.0.0.19", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth2, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // the first next hop's reply releases both of its datagrams, in order
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth1,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth1, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth1, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth1, EthernetHeader::TYPE_IPv4, serialize( datagram3 ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "pending queue is bounded", local_eth, Address( "10.0.0.1", 0 ) };
+
+      vector<InternetDatagram> datagrams;
+      for ( unsigned int i = 0; i < 100; i++ ) {
+        datagrams.push_back( make_datagram( "10.0.0.1", "20.0.0." + to_string( i ) ) );
+        test.execute( SendDatagram { datagrams.back(), Address( "10.0.0.5", 0 ) } );
+      }
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+
+      // the oldest 64 datagrams were kept; the rest were dropped
+      for ( unsigned int i = 0; i < 64; i++ ) {
+        test.execute( ExpectFrame {
+          make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagrams.at( i ) ) ) } );
+      }
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "mappings in use are refreshed", local_eth, Address( "10.0.0.1", 0 ) };
+
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth,
+          ETHERNET_BROADCAST,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.5", {}, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // shortly before the mapping expires, using it sends a unicast request as well as the datagram
+      test.execute( Tick { 28000 } );
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // only once
+      const auto datagram2 = make_datagram( "10.0.0.1", "4.10.4.10" );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.5", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // the reply renews the mapping, so there is no stall when the old one would have expired
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( Tick { 4000 } );
+      const auto datagram3 = make_datagram( "10.0.0.1", "144.144.144.144" );
+      test.execute( SendDatagram { datagram3, Address( "10.0.0.5", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram3 ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "unanswered refresh", local_eth, Address( "10.0.0.1", 0 ) };
+
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth,
+          ETHERNET_BROADCAST,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.5", {}, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ) } );
+
+      test.execute( Tick { 29000 } );
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+
+      // no reply: once the mapping expires, the next datagram waits for a broadcast request as usual
+      test.execute( Tick { 1000 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth1 = random_private_ethernet_address();
+      const EthernetAddress remote_eth2 = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "neighbor changes address", local_eth, Address( "10.0.0.1", 0 ) };
+
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth1,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth1, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth1, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+
+      // the new address replaces the old one in every frame that follows
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth2,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth2, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      const auto datagram2 = make_datagram( "10.0.0.1", "4.10.4.10" );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.5", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth2, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "unresponsive next hops back off", local_eth, Address( "10.0.0.1", 0 ) };
+
+      const auto request = make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) );
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+
+      // one unanswered request is retried as usual
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { request } );
+      test.execute( Tick { 5000 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { request } );
+      test.execute( ExpectNoFrame {} );
+
+      // after two, datagrams are dropped without a request for 5 s
+      test.execute( Tick { 5000 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( Tick { 4990 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( Tick { 10 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { request } );
+      test.execute( ExpectNoFrame {} );
+
+      // and after three, for 10 s
+      test.execute( Tick { 5000 } );
+      test.execute( Tick { 9990 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( Tick { 10 } );
+      const auto datagram2 = make_datagram( "10.0.0.1", "4.10.4.10" );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { request } );
+      test.execute( ExpectNoFrame {} );
+
+      // a reply ends the backoff
+      test.execute( ReceiveFrame {
+        make_frame(
+          remote_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.5", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "ARP broadcasts are rate-limited", local_eth, Address( "10.0.0.1", 0 ) };
+
+      const auto request_for = [&]( const string& ip ) {
+        return make_frame( local_eth,
+                           ETHERNET_BROADCAST,
+                           EthernetHeader::TYPE_ARP,
+                           serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, ip ) ) );
+      };
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+
+      // a burst of 32 requests, then nothing
+      for ( unsigned int i = 0; i < 40; i++ ) {
+        test.execute( SendDatagram { datagram, Address( "10.0.1." + to_string( i ), 0 ) } );
+      }
+      for ( unsigned int i = 0; i < 32; i++ ) {
+        test.execute( ExpectFrame { request_for( "10.0.1." + to_string( i ) ) } );
+      }
+      test.execute( ExpectNoFrame {} );
+
+      // then one more every 10 ms
+      test.execute( Tick { 10 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.1.32", 0 ) } );
+      test.execute( SendDatagram { datagram, Address( "10.0.1.33", 0 ) } );
+      test.execute( ExpectFrame { request_for( "10.0.1.32" ) } );
+      test.execute( ExpectNoFrame {} );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return EXIT_FAILURE;
@@ -0,0 +1,117 @@
+#include "net_interface_link.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+struct OverloadResult
+{
+  double queue_delay_ms {}; // average time frames waited in the interface's queue
+  double link_delay_ms {};  // average time from send_datagram() to delivery, in the second half of the run
+  double utilization {};    // fraction of the link's capacity delivered, in the second half of the run
+  TransmitQueue::Stats stats {};
+};
+
+// Offer 5 datagrams every 4 ms (about 10.3 Mbit/s) to the 10 Mbit/s link for `duration_ms`
+OverloadResult overload( const TransmitQueueConfig& config, const uint64_t duration_ms )
+{
+  constexpr size_t payload_size = 1000;
+  NetworkInterface interface = make_interface();
+  interface.set_tx_queue( config );
+
+  uint64_t delivered_bytes = 0;
+  uint64_t delivered = 0;
+  uint64_t total_delay_ms = 0;
+  drive_link(
+    interface,
+    duration_ms,
+    [&]( const uint64_t now_ms ) {
+      for ( uint64_t i = 0; i < ( now_ms % 4 ? 1 : 2 ); i++ ) {
+        interface.send_datagram( make_datagram( payload_size, now_ms ), remote_ip );
+      }
+    },
+    [&]( const InternetDatagram& dgram, const size_t bytes, const uint64_t now_ms ) {
+      if ( now_ms >= duration_ms / 2 ) {
+        total_delay_ms += now_ms + 1 - sent_at_ms( dgram );
+        delivered_bytes += bytes;
+        delivered++;
+      }
+    } );
+
+  if ( delivered == 0 ) {
+    throw runtime_error( "nothing was delivered" );
+  }
+  const double capacity_bytes
+    = static_cast<double>( LINK_BANDWIDTH_BPS ) / 8000 * static_cast<double>( duration_ms / 2 );
+  return { interface.tx_stats().average_delay_ms(),
+           static_cast<double>( total_delay_ms ) / static_cast<double>( delivered ),
+           static_cast<double>( delivered_bytes ) / capacity_bytes,
+           interface.tx_stats() };
+}
+
+void check_tail_drop()
+{
+  NetworkInterface interface = make_interface();
+  interface.set_tx_queue( { .discipline = QueueDiscipline::TailDrop, .limit = 4 } );
+  for ( int i = 0; i < 6; i++ ) {
+    interface.send_datagram( make_datagram( 100 ), remote_ip );
+  }
+  interface.tick( 3 );
+
+  size_t sent = 0;
+  while ( interface.maybe_send() ) {
+    sent++;
+  }
+  const auto& stats = interface.tx_stats();
+  if ( sent != 4 or stats.tail_drops != 2 or stats.drops() != 2 or stats.enqueued != 4 or stats.dequeued != 4 ) {
+    throw runtime_error( "a full tail-drop queue should drop arrivals" );
+  }
+  if ( stats.max_delay_ms != 3 or stats.average_delay_ms() != 3 ) {
+    throw runtime_error( "wrong queueing delay: " + to_string( stats.average_delay_ms() ) );
+  }
+}
+
+void check_overload()
+{
+  const OverloadResult tail = overload( { .discipline = QueueDiscipline::TailDrop, .limit = 256 }, 16000 );
+  const OverloadResult red = overload( { .discipline = QueueDiscipline::RED, .limit = 256 }, 16000 );
+  const OverloadResult codel = overload( { .discipline = QueueDiscipline::CoDel, .limit = 256 }, 16000 );
+
+  const auto describe = []( const string& name, const OverloadResult& r ) {
+    return name + ": queue delay " + to_string( r.queue_delay_ms ) + " ms, link delay "
+           + to_string( r.link_delay_ms ) + " ms, utilization " + to_string( r.utilization ) + ", drops "
+           + to_string( r.stats.drops() );
+  };
+
+  for ( const auto& [name, result] :
+        { pair { "tail drop", tail }, pair { "RED", red }, pair { "CoDel", codel } } ) {
+    if ( result.utilization < 0.95 ) {
+      throw runtime_error( describe( name, result ) + " (the link should stay busy)" );
+    }
+  }
+  if ( tail.link_delay_ms < 100 or tail.stats.tail_drops == 0 ) {
+    throw runtime_error( describe( "tail drop", tail ) + " (a full queue should have built up)" );
+  }
+  if ( red.link_delay_ms > tail.link_delay_ms / 4 or red.stats.early_drops == 0 ) {
+    throw runtime_error( describe( "RED", red ) + " (vs. " + describe( "tail drop", tail ) + ")" );
+  }
+  if ( codel.link_delay_ms > 20 or codel.stats.codel_drops == 0 or codel.stats.tail_drops != 0 ) {
+    throw runtime_error( describe( "CoDel", codel ) + " (vs. " + describe( "tail drop", tail ) + ")" );
+  }
+}
+
+int main()
+{
+  try {
+    check_tail_drop();
+    check_overload();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
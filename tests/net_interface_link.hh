@@ -0,0 +1,117 @@
+#pragma once
+
+#include "arp_message.hh"
+#include "link_emulator.hh"
+#include "network_interface.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// A NetworkInterface sending to one neighbor across an emulated 10 Mbit/s link, for tests of how the
+// interface queues and schedules its frames under load
+
+const EthernetAddress local_eth { 0x02, 0, 0, 0, 0, 1 };
+const EthernetAddress remote_eth { 0x02, 0, 0, 0, 0, 2 };
+const Address local_ip { "10.0.0.1", 0 };
+const Address remote_ip { "10.0.0.2", 0 };
+
+constexpr uint64_t LINK_BANDWIDTH_BPS = 10'000'000;
+
+// An interface that already knows its neighbor's Ethernet address
+inline NetworkInterface make_interface()
+{
+  NetworkInterface interface { local_eth, local_ip };
+
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REPLY;
+  arp.sender_ethernet_address = remote_eth;
+  arp.sender_ip_address = remote_ip.ipv4_numeric();
+  arp.target_ethernet_address = local_eth;
+  arp.target_ip_address = local_ip.ipv4_numeric();
+
+  EthernetFrame frame;
+  frame.header = { local_eth, remote_eth, EthernetHeader::TYPE_ARP };
+  frame.payload = serialize( arp );
+  interface.recv_frame( frame );
+  return interface;
+}
+
+// A datagram to the neighbor that records when it was sent (at the start of its payload)
+inline InternetDatagram make_datagram( const size_t payload_size, const uint64_t now_ms = 0, const uint8_t tos = 0 )
+{
+  std::string payload = std::to_string( now_ms );
+  payload.resize( payload_size, ' ' );
+
+  InternetDatagram dgram;
+  dgram.header.tos = tos;
+  dgram.header.src = local_ip.ipv4_numeric();
+  dgram.header.dst = remote_ip.ipv4_numeric();
+  dgram.header.len = IPv4Header::LENGTH + payload.size();
+  dgram.payload.emplace_back( std::move( payload ) );
+  dgram.header.compute_checksum();
+  return dgram;
+}
+
+inline InternetDatagram datagram_in( const EthernetFrame& frame )
+{
+  InternetDatagram dgram;
+  if ( not parse( dgram, frame.payload ) or dgram.payload.empty() ) {
+    throw std::runtime_error( "interface sent a frame that wasn't an IPv4 datagram" );
+  }
+  return dgram;
+}
+
+// When a datagram from make_datagram() was sent
+inline uint64_t sent_at_ms( const InternetDatagram& dgram )
+{
+  const std::string_view payload = dgram.payload.front();
+  return std::stoull( std::string( payload.substr( 0, payload.find( ' ' ) ) ) );
+}
+
+// Bytes of a frame on the wire
+inline size_t frame_bytes( const EthernetFrame& frame )
+{
+  size_t bytes = EthernetHeader::LENGTH;
+  for ( const auto& b : frame.payload ) {
+    bytes += b.size();
+  }
+  return bytes;
+}
+
+using Delivery = std::function<void( const InternetDatagram& dgram, size_t bytes, uint64_t now_ms )>;
+
+// Run the interface and the link for `duration_ms`, 1 ms at a time. Each ms, `offer` sends datagrams to the
+// interface, the interface hands the link a frame whenever it has fewer than two waiting (so the standing
+// queue is the interface's, as behind a NIC's small TX ring), and `deliver` sees every datagram that
+// arrives, with the size of its frame and the time.
+inline void drive_link( NetworkInterface& interface,
+                        const uint64_t duration_ms,
+                        const std::function<void( uint64_t now_ms )>& offer,
+                        const Delivery& deliver )
+{
+  LinkEmulator<EthernetFrame> link { { .bandwidth_bps = LINK_BANDWIDTH_BPS, .delay_us = 1000 } };
+
+  for ( uint64_t now_ms = 0; now_ms < duration_ms; now_ms++ ) {
+    offer( now_ms );
+    while ( link.backlog() < 2 ) {
+      auto frame = interface.maybe_send();
+      if ( not frame ) {
+        break;
+      }
+      const size_t bytes = frame_bytes( *frame );
+      link.send( std::move( *frame ), bytes );
+    }
+
+    interface.tick( 1 );
+    link.advance( 1000 );
+
+    while ( auto frame = link.receive() ) {
+      deliver( datagram_in( *frame ), frame_bytes( *frame ), now_ms );
+    }
+  }
+}
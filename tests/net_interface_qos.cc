@@ -0,0 +1,165 @@
+#include "net_interface_link.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+constexpr uint8_t TOS_BEST_EFFORT = 0;
+constexpr uint8_t TOS_AF11 = 10 << 2;
+constexpr uint8_t TOS_EF = 46 << 2; // Expedited Forwarding, for interactive traffic
+
+NetworkInterface make_interface( const EgressConfig& config )
+{
+  NetworkInterface interface = make_interface();
+  interface.set_egress( config );
+  return interface;
+}
+
+// EF goes ahead of everything else, whatever order the datagrams were sent in
+void check_strict_priority()
+{
+  EgressConfig config;
+  config.classes = { { .strict = true }, {} };
+  config.dscp_class.fill( 1 );
+  config.dscp_class[TOS_EF >> 2] = 0;
+  NetworkInterface interface = make_interface( config );
+
+  for ( const uint8_t tos : { TOS_BEST_EFFORT, TOS_BEST_EFFORT, TOS_EF, TOS_BEST_EFFORT, TOS_EF } ) {
+    interface.send_datagram( make_datagram( 100, 0, tos ), remote_ip );
+  }
+
+  vector<uint8_t> order;
+  while ( auto frame = interface.maybe_send() ) {
+    order.push_back( datagram_in( *frame ).header.tos );
+  }
+  const vector<uint8_t> expected { TOS_EF, TOS_EF, TOS_BEST_EFFORT, TOS_BEST_EFFORT, TOS_BEST_EFFORT };
+  if ( order != expected ) {
+    throw runtime_error( "strict-priority class wasn't served first" );
+  }
+  if ( interface.tx_stats( 0 ).dequeued != 2 or interface.tx_stats( 1 ).dequeued != 3
+       or interface.tx_stats().dequeued != 5 ) {
+    throw runtime_error( "wrong per-class counters" );
+  }
+}
+
+// Two backlogged round-robin classes share the link in proportion to their quanta, counted in bytes
+void check_weights( const size_t quantum_af11,
+                    const size_t payload_af11,
+                    const size_t quantum_best_effort,
+                    const size_t payload_best_effort,
+                    const double expected_share_af11 )
+{
+  EgressConfig config;
+  config.classes = { { .quantum = quantum_best_effort }, { .quantum = quantum_af11 } };
+  config.dscp_class[TOS_AF11 >> 2] = 1;
+  NetworkInterface interface = make_interface( config );
+
+  for ( int i = 0; i < 400; i++ ) {
+    interface.send_datagram( make_datagram( payload_best_effort, 0, TOS_BEST_EFFORT ), remote_ip );
+    interface.send_datagram( make_datagram( payload_af11, 0, TOS_AF11 ), remote_ip );
+  }
+
+  // Look at the first 200 frames, while both classes are still backlogged
+  size_t bytes_af11 = 0;
+  size_t bytes_total = 0;
+  for ( int i = 0; i < 200; i++ ) {
+    const auto frame = interface.maybe_send();
+    if ( not frame ) {
+      throw runtime_error( "interface ran out of frames" );
+    }
+    bytes_total += frame_bytes( *frame );
+    if ( datagram_in( *frame ).header.tos == TOS_AF11 ) {
+      bytes_af11 += frame_bytes( *frame );
+    }
+  }
+
+  const double share = static_cast<double>( bytes_af11 ) / static_cast<double>( bytes_total );
+  if ( share < expected_share_af11 - 0.03 or share > expected_share_af11 + 0.03 ) {
+    throw runtime_error( "AF11 got " + to_string( share ) + " of the bytes instead of "
+                         + to_string( expected_share_af11 ) );
+  }
+}
+
+// Average delay of EF datagrams (one every 10 ms) sent alongside bulk traffic that overloads the link
+double interactive_delay_ms( const EgressConfig& config )
+{
+  constexpr uint64_t duration_ms = 4000;
+  NetworkInterface interface = make_interface( config );
+  interface.set_tx_queue( { .limit = 256 } );
+
+  uint64_t delivered = 0;
+  uint64_t total_delay_ms = 0;
+  drive_link(
+    interface,
+    duration_ms,
+    [&]( const uint64_t now_ms ) {
+      if ( now_ms % 10 == 0 ) {
+        interface.send_datagram( make_datagram( 100, now_ms, TOS_EF ), remote_ip );
+      }
+      for ( uint64_t i = 0; i < 1 + now_ms % 2; i++ ) {
+        interface.send_datagram( make_datagram( 1000, now_ms, TOS_BEST_EFFORT ), remote_ip );
+      }
+    },
+    [&]( const InternetDatagram& dgram, size_t, const uint64_t now_ms ) {
+      if ( dgram.header.tos == TOS_EF and now_ms >= duration_ms / 2 ) {
+        total_delay_ms += now_ms + 1 - sent_at_ms( dgram );
+        delivered++;
+      }
+    } );
+
+  if ( delivered == 0 ) {
+    throw runtime_error( "no EF datagrams were delivered" );
+  }
+  return static_cast<double>( total_delay_ms ) / static_cast<double>( delivered );
+}
+
+void check_congested_uplink()
+{
+  const double shared = interactive_delay_ms( {} );
+
+  EgressConfig config;
+  config.classes = { { .strict = true }, {} };
+  config.dscp_class.fill( 1 );
+  config.dscp_class[TOS_EF >> 2] = 0;
+  const double prioritized = interactive_delay_ms( config );
+
+  if ( shared < 100 or prioritized > 5 ) {
+    throw runtime_error( "EF delay was " + to_string( prioritized ) + " ms with its own class and "
+                         + to_string( shared ) + " ms in one shared queue" );
+  }
+}
+
+void check_bad_config()
+{
+  EgressConfig config;
+  config.dscp_class[TOS_EF >> 2] = 1; // but there is only one class
+  bool threw = false;
+  try {
+    make_interface( config );
+  } catch ( const invalid_argument& ) {
+    threw = true;
+  }
+  if ( not threw ) {
+    throw runtime_error( "a DSCP value mapped to a missing class should be rejected" );
+  }
+}
+
+int main()
+{
+  try {
+    check_strict_priority();
+    check_weights( 3000, 1000, 1000, 1000, 0.75 ); // same sizes, weighted 3:1
+    check_weights( 1500, 100, 1500, 1400, 0.5 );   // equal weights, but very different frame sizes
+    check_congested_uplink();
+    check_bad_config();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include "arp_message.hh"
+#include "network_interface.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr uint32_t local_ip = 0x0a000001;
+
+EthernetAddress neighbor_ethernet_address( const uint32_t i )
+{
+  return { 0x02,
+           0,
+           static_cast<uint8_t>( i >> 24 ),
+           static_cast<uint8_t>( i >> 16 ),
+           static_cast<uint8_t>( i >> 8 ),
+           static_cast<uint8_t>( i ) };
+}
+
+// Teach the interface a neighbor's mapping with an ARP request addressed to it
+void learn_neighbor( NetworkInterface& interface, const EthernetAddress& local_eth, const uint32_t ip )
+{
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REQUEST;
+  arp.sender_ethernet_address = neighbor_ethernet_address( ip );
+  arp.sender_ip_address = ip;
+  arp.target_ip_address = local_ip;
+
+  EthernetFrame frame;
+  frame.header = { local_eth, arp.sender_ethernet_address, EthernetHeader::TYPE_ARP };
+  frame.payload = serialize( arp );
+  interface.recv_frame( frame );
+  while ( interface.maybe_send() ) {}
+}
+
+void speed_test( const size_t neighbors, const size_t ticks )
+{
+  const EthernetAddress local_eth { 0x02, 0, 0, 0, 0, 1 };
+  NetworkInterface interface { local_eth, Address::from_ipv4_numeric( local_ip ) };
+
+  vector<Address> neighbor_addresses;
+  for ( uint32_t i = 0; i < neighbors; i++ ) {
+    neighbor_addresses.push_back( Address::from_ipv4_numeric( 0x0b000000 + i ) );
+    learn_neighbor( interface, local_eth, 0x0b000000 + i );
+  }
+
+  // 1 ms ticks, with every neighbor's mapping alive the whole time
+  const auto tick_start = steady_clock::now();
+  for ( size_t i = 0; i < ticks; i++ ) {
+    interface.tick( 1 );
+  }
+  const auto tick_stop = steady_clock::now();
+
+  // Send to known neighbors (one cache lookup each), serializing each frame as a driver would
+  InternetDatagram dgram;
+  dgram.header.src = local_ip;
+  dgram.payload = { string( 64, 'x' ) };
+  dgram.header.len = IPv4Header::LENGTH + 64;
+  dgram.header.compute_checksum();
+
+  const size_t sends = 200000;
+  size_t frames = 0;
+  size_t wire_bytes = 0;
+  const auto send_start = steady_clock::now();
+  for ( size_t i = 0; i < sends; i++ ) {
+    interface.send_datagram( dgram, neighbor_addresses[i % neighbors] );
+    const auto wire = interface.maybe_send_serialized();
+    if ( wire.has_value() ) {
+      frames++;
+      wire_bytes += wire->size();
+    }
+  }
+  const auto send_stop = steady_clock::now();
+
+  if ( frames != sends or wire_bytes == 0 ) {
+    throw runtime_error( "NetworkInterface didn't send to a neighbor whose mapping it knew" );
+  }
+
+  const double ns_per_tick = duration_cast<duration<double, nano>>( tick_stop - tick_start ).count() / ticks;
+  const double ns_per_send = duration_cast<duration<double, nano>>( send_stop - send_start ).count() / sends;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "NetworkInterface with " << neighbors << " neighbors: " << fixed << setprecision( 1 ) << ns_per_tick
+       << " ns per 1 ms tick, " << ns_per_send << " ns per datagram sent.\n";
+
+  debug_output << "             NetworkInterface (" << neighbors << " neighbors): " << fixed << setprecision( 1 )
+               << ns_per_tick << " ns/tick, " << ns_per_send << " ns/send\n";
+
+  if ( ns_per_send > 100000 ) {
+    throw runtime_error( "NetworkInterface did not meet minimum rate of 10k datagrams/s." );
+  }
+}
+
+// Bursts of 32 sends followed by draining the interface, to neighbors that are known (one frame each) or
+// unknown (a broadcast ARP request each, from a fresh address so that none is negatively cached)
+void burst_test( const bool resolved, const size_t bursts )
+{
+  constexpr size_t burst = 32;
+  const EthernetAddress local_eth { 0x02, 0, 0, 0, 0, 1 };
+  NetworkInterface interface { local_eth, Address::from_ipv4_numeric( local_ip ) };
+
+  vector<Address> neighbor_addresses;
+  for ( uint32_t i = 0; i < burst; i++ ) {
+    neighbor_addresses.push_back( Address::from_ipv4_numeric( 0x0b000000 + i ) );
+    learn_neighbor( interface, local_eth, 0x0b000000 + i );
+  }
+
+  InternetDatagram dgram;
+  dgram.header.src = local_ip;
+  dgram.payload = { string( 64, 'x' ) };
+  dgram.header.len = IPv4Header::LENGTH + 64;
+  dgram.header.compute_checksum();
+
+  size_t frames = 0;
+  steady_clock::duration elapsed {};
+  for ( size_t b = 0; b < bursts; b++ ) {
+    if ( not resolved ) {
+      for ( uint32_t i = 0; i < burst; i++ ) {
+        neighbor_addresses[i] = Address::from_ipv4_numeric( 0x0c000000 + b * burst + i );
+      }
+    }
+
+    const auto start = steady_clock::now();
+    for ( const auto& next_hop : neighbor_addresses ) {
+      interface.send_datagram( dgram, next_hop );
+    }
+    while ( interface.maybe_send() ) {
+      frames++;
+    }
+    elapsed += steady_clock::now() - start;
+
+    // (untimed) let the ARP rate limit refill, and keep the mappings alive
+    interface.tick( 1000 );
+    if ( resolved and b % 16 == 15 ) {
+      for ( uint32_t i = 0; i < burst; i++ ) {
+        learn_neighbor( interface, local_eth, 0x0b000000 + i );
+      }
+    }
+  }
+
+  if ( frames != bursts * burst ) {
+    throw runtime_error( "NetworkInterface sent " + to_string( frames ) + " frames instead of "
+                         + to_string( bursts * burst ) );
+  }
+
+  const double ns_per_frame = duration_cast<duration<double, nano>>( elapsed ).count() / frames;
+  const string kind = resolved ? "IPv4 frames" : "ARP requests";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "NetworkInterface TX bursts of " << burst << " " << kind << ": " << fixed << setprecision( 1 )
+       << ns_per_frame << " ns per frame.\n";
+
+  debug_output << "             NetworkInterface TX burst (" << kind << "): " << fixed << setprecision( 1 )
+               << ns_per_frame << " ns/frame\n";
+
+  if ( ns_per_frame > 100000 ) {
+    throw runtime_error( "NetworkInterface did not meet minimum rate of 10k frames/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 16, 20000 );
+  speed_test( 4096, 20000 );
+  burst_test( true, 2000 );
+  burst_test( false, 2000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+#include "packet_buffer.hh"
+#include "tcp_segment.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+template<class T>
+string serialized( const T& obj )
+{
+  string out;
+  for ( const auto& b : serialize( obj ) ) {
+    out.append( static_cast<string_view>( b ) );
+  }
+  return out;
+}
+
+void check_encapsulation( const size_t headroom )
+{
+  const vector<Buffer> payload { string( "hello, " ), string(), string( "world" ) };
+
+  TCPHeader tcp { .sport = 443, .dport = 51000, .seqno = 1, .ackno = 2, .ack = true, .win = 1000 };
+  tcp.timestamps = TCPTimestamps { 7, 8 };
+  tcp.doff = tcp.serialized_length() / 4;
+
+  IPv4Header ip;
+  ip.len = IPv4Header::LENGTH + tcp.serialized_length() + 12;
+  ip.src = 0x0a000001;
+  ip.dst = 0x0a000002;
+  ip.compute_checksum();
+
+  EthernetHeader ethernet { .dst = ETHERNET_BROADCAST, .src = { 2, 0, 0, 0, 0, 1 }, .type = 0x800 };
+
+  PacketBuffer packet { headroom };
+  packet.append( payload );
+  packet.push_header( tcp );
+  packet.push_header( ip );
+  packet.push_header( ethernet );
+
+  const string expected = serialized( ethernet ) + serialized( ip ) + serialized( tcp ) + "hello, world";
+  if ( packet.data() != expected or packet.size() != expected.size() ) {
+    throw runtime_error( "PacketBuffer with headroom " + to_string( headroom ) + " built the wrong frame" );
+  }
+
+  const char* first_byte = packet.data().data();
+  const Buffer released = packet.release();
+  if ( static_cast<string_view>( released ) != expected ) {
+    throw runtime_error( "PacketBuffer::release() returned the wrong bytes" );
+  }
+  if ( static_cast<string_view>( released ).data() != first_byte ) {
+    throw runtime_error( "PacketBuffer::release() moved the packet" );
+  }
+}
+
+int main()
+{
+  try {
+    // Enough headroom, and not enough (so that prepend() has to grow the buffer)
+    check_encapsulation( PacketBuffer::DEFAULT_HEADROOM );
+    check_encapsulation( 0 );
+    check_encapsulation( 30 );
+
+    PacketBuffer packet;
+    if ( packet.size() != 0 or packet.headroom() != PacketBuffer::DEFAULT_HEADROOM ) {
+      throw runtime_error( "new PacketBuffer should be empty with the default headroom" );
+    }
+    packet.append( "x" );
+    packet.prepend( 4 );
+    if ( packet.size() != 5 or packet.headroom() != PacketBuffer::DEFAULT_HEADROOM - 4 ) {
+      throw runtime_error( "PacketBuffer::prepend() didn't take its bytes from the headroom" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
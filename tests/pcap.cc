@@ -0,0 +1,314 @@
+#include "arp_message.hh"
+#include "network_interface.hh"
+#include "pcap.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+void expect( const bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+// A file in /tmp that is deleted when the test is done with it
+class TempFile
+{
+  string path_;
+
+public:
+  TempFile() : path_( "/tmp/minnow-pcap-XXXXXX" )
+  {
+    const int fd = mkstemp( path_.data() );
+    if ( fd < 0 ) {
+      throw runtime_error( "mkstemp failed" );
+    }
+    close( fd );
+  }
+  ~TempFile() { unlink( path_.c_str() ); }
+  TempFile( const TempFile& other ) = delete;
+  TempFile& operator=( const TempFile& other ) = delete;
+
+  const string& path() const { return path_; }
+};
+
+EthernetFrame make_frame( const size_t i, const size_t payload_size )
+{
+  EthernetFrame frame;
+  frame.header.dst = { 0x02, 0, 0, 0, 0, static_cast<uint8_t>( i ) };
+  frame.header.src = { 0x02, 0, 0, 0, 1, static_cast<uint8_t>( i >> 8 ) };
+  frame.header.type = EthernetHeader::TYPE_IPv4;
+  frame.payload = { string( payload_size, static_cast<char>( 'a' + i % 26 ) ) };
+  return frame;
+}
+
+void expect_same( const EthernetFrame& expected, const PcapRecord& record, const string& what )
+{
+  const vector<Buffer> wire = serialize( expected );
+  string expected_bytes;
+  for ( const auto& b : wire ) {
+    expected_bytes.append( b );
+  }
+  expect( static_cast<string_view>( record.data ) == expected_bytes, what + " has the wrong bytes" );
+  expect( record.original_length == expected_bytes.size(), what + " has the wrong original length" );
+}
+
+// Frames written (both from their fields and as serialized bytes) come back unchanged, with their timestamps
+void check_roundtrip()
+{
+  const TempFile file;
+  vector<EthernetFrame> frames;
+  {
+    PcapWriter writer { file.path() };
+    for ( size_t i = 0; i < 100; i++ ) {
+      frames.push_back( make_frame( i, 46 + i * 10 ) );
+      if ( i % 2 ) {
+        // as sent by NetworkInterface::maybe_send_serialized, in one Buffer
+        string bytes;
+        for ( const auto& b : serialize( frames.back() ) ) {
+          bytes.append( b );
+        }
+        const Buffer wire { std::move( bytes ) };
+        writer.write( { &wire, 1 }, 1'700'000'000'000'000'000 + i * 1'000'123 );
+      } else {
+        writer.write( frames.back(), 1'700'000'000'000'000'000 + i * 1'000'123 );
+      }
+    }
+    expect( writer.records() == 100, "writer miscounted its records" );
+  }
+
+  PcapReader reader { file.path() };
+  for ( size_t i = 0; i < frames.size(); i++ ) {
+    const auto record = reader.next();
+    expect( record.has_value(), "reader ran out of records at " + to_string( i ) );
+    expect( record->timestamp_ns == 1'700'000'000'000'000'000 + i * 1'000'123,
+            "record " + to_string( i ) + " has the wrong timestamp" );
+    expect_same( frames[i], *record, "record " + to_string( i ) );
+  }
+  expect( not reader.next().has_value(), "reader returned a record past the end" );
+  expect( reader.records() == 100, "reader miscounted its records" );
+}
+
+// A capture written big-endian with microsecond timestamps, as by another machine
+void check_foreign_file()
+{
+  const TempFile file;
+  {
+    auto u32 = []( string& out, const uint32_t v ) {
+      for ( int shift = 24; shift >= 0; shift -= 8 ) {
+        out.push_back( static_cast<char>( v >> shift ) );
+      }
+    };
+    string bytes;
+    u32( bytes, 0xa1b2c3d4 );
+    bytes.append( { 0, 2, 0, 4 } );
+    u32( bytes, 0 );
+    u32( bytes, 0 );
+    u32( bytes, 65535 );
+    u32( bytes, PcapReader::LINKTYPE_ETHERNET );
+
+    u32( bytes, 12 );     // seconds
+    u32( bytes, 345678 ); // microseconds
+    u32( bytes, 20 );     // captured length
+    u32( bytes, 1500 );   // original length
+    bytes.append( "0123456789abcdefghij" );
+    ofstream { file.path(), ios::binary } << bytes;
+  }
+
+  PcapReader reader { file.path() };
+  expect( reader.snaplen() == 65535, "wrong snaplen in a big-endian file" );
+  const auto record = reader.next();
+  expect( record.has_value(), "no record in a big-endian file" );
+  expect( record->timestamp_ns == 12'345'678'000, "microsecond timestamp was misread" );
+  expect( record->original_length == 1500, "original length was misread" );
+  expect( static_cast<string_view>( record->data ) == "0123456789abcdefghij", "record bytes were misread" );
+  expect( not reader.next().has_value(), "reader returned a record past the end" );
+}
+
+// Enough records that many of them straddle the reader's chunks, and a snaplen shorter than some frames
+void check_large_file()
+{
+  const TempFile file;
+  constexpr size_t count = 3000;
+  constexpr uint32_t snaplen = 1200;
+  {
+    PcapWriter writer { file.path(), snaplen };
+    for ( size_t i = 0; i < count; i++ ) {
+      writer.write( make_frame( i, 46 + i % 1454 ), i );
+    }
+  }
+
+  PcapReader reader { file.path() };
+  size_t i = 0;
+  while ( auto record = reader.next() ) {
+    const size_t length = EthernetHeader::LENGTH + 46 + i % 1454;
+    expect( record->original_length == length, "record " + to_string( i ) + " has the wrong original length" );
+    expect( record->data.size() == min<size_t>( length, snaplen ),
+            "record " + to_string( i ) + " wasn't truncated" );
+    expect( static_cast<string_view>( record->data ).substr( EthernetHeader::LENGTH )
+              == string( record->data.size() - EthernetHeader::LENGTH, static_cast<char>( 'a' + i % 26 ) ),
+            "record " + to_string( i ) + " has the wrong bytes" );
+    i++;
+  }
+  expect( i == count, "read " + to_string( i ) + " records instead of " + to_string( count ) );
+}
+
+void check_bad_files()
+{
+  const TempFile file;
+  {
+    PcapWriter writer { file.path() };
+    writer.write( make_frame( 0, 100 ), 0 );
+    writer.write( make_frame( 1, 100 ), 0 );
+  }
+  const size_t size = EthernetHeader::LENGTH + 100;
+  if ( truncate( file.path().c_str(), 24 + 2 * 16 + 2 * static_cast<off_t>( size ) - 10 ) != 0 ) {
+    throw runtime_error( "truncate failed" );
+  }
+
+  PcapReader reader { file.path() };
+  expect( reader.next().has_value(), "the first record is intact" );
+  bool threw = false;
+  try {
+    reader.next();
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "a truncated record should be an error" );
+
+  ofstream { file.path(), ios::binary } << "not a capture file at all";
+  threw = false;
+  try {
+    PcapReader not_pcap { file.path() };
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "a file without the pcap magic number should be rejected" );
+}
+
+// Replay ticks by recorded time, delivers parseable frames and skips the rest
+void check_replay()
+{
+  const TempFile file;
+  {
+    PcapWriter writer { file.path() };
+    const uint64_t start = 5'000'000'000;
+    writer.write( make_frame( 0, 46 ), start );
+    writer.write( make_frame( 1, 46 ), start + 400'000 );     // 0.4 ms later: no tick yet
+    writer.write( make_frame( 2, 46 ), start + 2'100'000 );   // 2.1 ms
+    const vector<Buffer> runt { Buffer { string( 5, 'x' ) } }; // too short to be a frame
+    writer.write( runt, start + 2'500'000 );
+    writer.write( make_frame( 3, 46 ), start + 1'000'000 );   // out of order: no tick
+    writer.write( make_frame( 4, 46 ), start + 250'000'000 ); // 250 ms
+  }
+
+  PcapReader reader { file.path() };
+  vector<size_t> delivered;
+  vector<uint64_t> ticks;
+  const ReplayStats stats = replay(
+    reader,
+    [&]( const EthernetFrame& frame ) { delivered.push_back( frame.header.dst.back() ); },
+    [&]( const uint64_t ms ) { ticks.push_back( ms ); } );
+
+  expect( delivered == vector<size_t> { 0, 1, 2, 3, 4 }, "replay delivered the wrong frames" );
+  expect( ticks == vector<uint64_t> { 2, 248 }, "replay ticked the wrong amounts" );
+  expect( stats.frames == 5 and stats.malformed == 1, "replay miscounted" );
+  expect( stats.bytes == 5 * ( EthernetHeader::LENGTH + 46 ), "replay miscounted bytes" );
+}
+
+// An interface with capture on records the ARP exchange and the datagram that waited for it, as it sends them
+void check_capture()
+{
+  const EthernetAddress local_eth { 0x02, 0, 0, 0, 0, 1 };
+  const EthernetAddress remote_eth { 0x02, 0, 0, 0, 0, 2 };
+  const Address local_ip { "10.0.0.1", 0 };
+  const Address remote_ip { "10.0.0.2", 0 };
+
+  InternetDatagram dgram;
+  dgram.header.src = local_ip.ipv4_numeric();
+  dgram.header.dst = remote_ip.ipv4_numeric();
+  dgram.header.len = IPv4Header::LENGTH + 5;
+  dgram.payload.emplace_back( string( "hello" ) );
+  dgram.header.compute_checksum();
+
+  const TempFile file;
+  vector<EthernetFrame> sent;
+  Buffer sent_serialized;
+  {
+    PcapWriter writer { file.path() };
+    NetworkInterface interface { local_eth, local_ip };
+    interface.set_capture( writer );
+
+    interface.send_datagram( dgram, remote_ip );
+    interface.tick( 3 );
+    auto request = interface.maybe_send();
+    expect( request.has_value() and request->header.type == EthernetHeader::TYPE_ARP,
+            "interface didn't ask for its next hop's address" );
+    sent.push_back( std::move( *request ) );
+
+    ARPMessage reply;
+    reply.opcode = ARPMessage::OPCODE_REPLY;
+    reply.sender_ethernet_address = remote_eth;
+    reply.sender_ip_address = remote_ip.ipv4_numeric();
+    reply.target_ethernet_address = local_eth;
+    reply.target_ip_address = local_ip.ipv4_numeric();
+    EthernetFrame reply_frame;
+    reply_frame.header = { local_eth, remote_eth, EthernetHeader::TYPE_ARP };
+    reply_frame.payload = serialize( reply );
+    interface.recv_frame( reply_frame );
+
+    interface.tick( 2 );
+    auto waiting = interface.maybe_send_serialized();
+    expect( waiting.has_value(), "interface didn't send the datagram waiting for ARP" );
+    sent_serialized = std::move( *waiting );
+
+    interface.send_datagram( dgram, remote_ip );
+    auto direct = interface.maybe_send();
+    expect( direct.has_value(), "interface didn't send a datagram to a known neighbor" );
+    sent.push_back( std::move( *direct ) );
+    expect( not interface.maybe_send().has_value(), "interface sent an extra frame" );
+
+    interface.set_capture( {} );
+    interface.send_datagram( dgram, remote_ip );
+    expect( interface.maybe_send().has_value(), "interface didn't send with capture off" );
+    expect( writer.records() == 3, "capture recorded the wrong number of frames" );
+  }
+
+  PcapReader reader { file.path() };
+  const auto request = reader.next();
+  const auto waiting = reader.next();
+  const auto direct = reader.next();
+  expect( request and waiting and direct and not reader.next(), "capture file has the wrong number of records" );
+  expect_same( sent[0], *request, "captured ARP request" );
+  expect( static_cast<string_view>( waiting->data ) == static_cast<string_view>( sent_serialized ),
+          "captured serialized frame has the wrong bytes" );
+  expect_same( sent[1], *direct, "captured frame" );
+  expect( request->timestamp_ns == 3'000'000 and waiting->timestamp_ns == 5'000'000
+            and direct->timestamp_ns == 5'000'000,
+          "captured frames have the wrong timestamps" );
+}
+
+int main()
+{
+  try {
+    check_roundtrip();
+    check_foreign_file();
+    check_large_file();
+    check_bad_files();
+    check_replay();
+    check_capture();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
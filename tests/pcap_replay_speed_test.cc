@@ -0,0 +1,195 @@
+#include "arp_message.hh"
+#include "network_interface.hh"
+#include "pcap.hh"
+#include "router.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+const EthernetAddress host_eth { 0x02, 0, 0, 0, 0, 1 };
+const EthernetAddress router_eth { 0x02, 0, 0, 0, 0, 2 };
+const EthernetAddress uplink_eth { 0x02, 0, 0, 0, 0, 3 };
+const EthernetAddress gateway_eth { 0x02, 0, 0, 0, 0, 4 };
+const Address host_ip { "10.1.0.1", 0 };
+const Address router_ip { "10.1.0.2", 0 };
+const Address uplink_ip { "10.2.0.1", 0 };
+const Address gateway_ip { "10.2.0.2", 0 };
+
+// Tell `interface` (at local_eth/local_ip) where the neighbor is
+template<class Interface>
+void learn_neighbor( Interface& interface,
+                     const EthernetAddress& local_eth,
+                     const Address& local_ip,
+                     const EthernetAddress& neighbor_eth,
+                     const Address& neighbor_ip )
+{
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REPLY;
+  arp.sender_ethernet_address = neighbor_eth;
+  arp.sender_ip_address = neighbor_ip.ipv4_numeric();
+  arp.target_ethernet_address = local_eth;
+  arp.target_ip_address = local_ip.ipv4_numeric();
+
+  EthernetFrame frame;
+  frame.header = { local_eth, neighbor_eth, EthernetHeader::TYPE_ARP };
+  frame.payload = serialize( arp );
+  interface.recv_frame( frame );
+}
+
+void report( const string& what, const size_t frames, const steady_clock::duration elapsed )
+{
+  const double seconds = duration_cast<duration<double>>( elapsed ).count();
+  const double ns_per_frame = seconds * 1e9 / static_cast<double>( frames );
+  const double frames_per_second = static_cast<double>( frames ) / seconds;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << what << ": " << frames << " frames, " << fixed << setprecision( 0 ) << frames_per_second
+       << " frames/s, " << setprecision( 1 ) << ns_per_frame << " ns per frame.\n";
+
+  debug_output << "             " << what << ": " << fixed << setprecision( 2 ) << frames_per_second / 1e6
+               << " Mframes/s, " << setprecision( 1 ) << ns_per_frame << " ns/frame\n";
+
+  if ( ns_per_frame > 100000 ) {
+    throw runtime_error( what + " did not meet minimum rate of 10k frames/s." );
+  }
+}
+
+// Capture what a host sends to the router (datagrams of varied sizes to many destinations) with a tap on
+// the host interface, one frame per microsecond of recorded time
+void synthesize_trace( const string& path, const size_t count )
+{
+  NetworkInterface host { host_eth, host_ip };
+  learn_neighbor( host, host_eth, host_ip, router_eth, router_ip );
+
+  PcapWriter writer { path };
+  host.set_capture( [&]( span<const Buffer> frame, uint64_t ) { writer.write( frame, writer.records() * 1000 ); } );
+
+  const auto start = steady_clock::now();
+  for ( size_t i = 0; i < count; i++ ) {
+    const size_t payload_size = 18 + ( i * 7919 ) % 1400;
+    InternetDatagram dgram;
+    dgram.header.src = host_ip.ipv4_numeric();
+    dgram.header.dst = 0x14000000 + static_cast<uint32_t>( i * 2654435761U % 0x00ffffff );
+    dgram.header.len = IPv4Header::LENGTH + payload_size;
+    dgram.payload.emplace_back( string( payload_size, 'x' ) );
+    dgram.header.compute_checksum();
+    host.send_datagram( dgram, router_ip );
+    while ( host.maybe_send_serialized() ) {}
+  }
+  writer.flush();
+  report( "NetworkInterface send with capture", writer.records(), steady_clock::now() - start );
+}
+
+void replay_to_interface( const string& path )
+{
+  NetworkInterface interface { router_eth, router_ip };
+  PcapReader reader { path };
+  size_t datagrams = 0;
+
+  const auto start = steady_clock::now();
+  const ReplayStats stats = replay(
+    reader,
+    [&]( const EthernetFrame& frame ) {
+      if ( interface.recv_frame( frame ).has_value() ) {
+        datagrams++;
+      }
+      while ( interface.maybe_send() ) {}
+    },
+    [&]( const uint64_t ms ) { interface.tick( ms ); } );
+  const auto stop = steady_clock::now();
+
+  if ( stats.frames == 0 ) {
+    throw runtime_error( "trace held no Ethernet frames" );
+  }
+  report( "pcap replay into NetworkInterface (" + to_string( datagrams ) + " datagrams)", stats.frames,
+          stop - start );
+}
+
+void replay_to_router( const string& path )
+{
+  Router router;
+  router.add_interface( AsyncNetworkInterface { router_eth, router_ip } );
+  router.add_interface( AsyncNetworkInterface { uplink_eth, uplink_ip } );
+  router.add_route( router_ip.ipv4_numeric() & 0xffff0000, 16, {}, 0 );
+  router.add_route( 0, 0, gateway_ip, 1 );
+  learn_neighbor( router.interface( 1 ), uplink_eth, uplink_ip, gateway_eth, gateway_ip );
+
+  PcapReader reader { path };
+  size_t forwarded = 0;
+
+  const auto start = steady_clock::now();
+  const ReplayStats stats = replay(
+    reader,
+    [&]( const EthernetFrame& frame ) {
+      router.interface( 0 ).recv_frame( frame );
+      router.route();
+      for ( size_t i = 0; i < 2; i++ ) {
+        while ( auto sent = router.interface( i ).maybe_send() ) {
+          forwarded += sent->header.type == EthernetHeader::TYPE_IPv4;
+        }
+      }
+    },
+    [&]( const uint64_t ms ) {
+      router.interface( 0 ).tick( ms );
+      router.interface( 1 ).tick( ms );
+    } );
+  const auto stop = steady_clock::now();
+
+  report( "pcap replay into Router (" + to_string( forwarded ) + " forwarded)", stats.frames, stop - start );
+}
+
+void program_body( const string& trace )
+{
+  string path = trace;
+  if ( path.empty() ) {
+    path = "/tmp/minnow-replay-XXXXXX";
+    const int fd = mkstemp( path.data() );
+    if ( fd < 0 ) {
+      throw runtime_error( "mkstemp failed" );
+    }
+    close( fd );
+    synthesize_trace( path, 200000 );
+  }
+
+  try {
+    replay_to_interface( path );
+    replay_to_router( path );
+  } catch ( ... ) {
+    if ( trace.empty() ) {
+      unlink( path.c_str() );
+    }
+    throw;
+  }
+  if ( trace.empty() ) {
+    unlink( path.c_str() );
+  }
+}
+
+// Usage: pcap_replay_speed_test [trace.pcap] (without a trace, one is synthesized)
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort(); // For sticklers: don't try to access argv[0] if argc <= 0.
+    }
+    auto args = span( argv, argc );
+    program_body( args.size() > 1 ? args[1] : "" );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 using ReceiverSet = std::pair<StreamAndReassembler, TCPReceiver>;
 
@@ -34,6 +35,14 @@ public:
                    { { ByteStream { capacity }, Reassembler {} }, TCPReceiver {} } )
   {}
 
+  TCPReceiverTestHarness( std::string test_name, uint64_t capacity, const TCPConfig& config )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ),
+                   { { ByteStream { capacity }, Reassembler {} }, TCPReceiver { config } } )
+  {}
+
+  uint64_t available_capacity() const { return object().first.first.writer().available_capacity(); }
+
   template<std::derived_from<TestStep<StreamAndReassembler>> T>
   void execute( const T& test )
   {
@@ -171,3 +180,87 @@ struct SegmentArrives : public Action<ReceiverSet>
     return ss.str();
   }
 };
+
+struct SegmentsArrive : public Action<ReceiverSet>
+{
+  std::vector<TCPSenderMessage> msgs_ {};
+
+  SegmentsArrive& with_segment( const SegmentArrives& seg )
+  {
+    msgs_.push_back( seg.msg_ );
+    return *this;
+  }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    rs.second.receive_batch( msgs_, rs.first.second, rs.first.first.writer() );
+  }
+
+  std::string description() const override
+  {
+    std::ostringstream ss;
+    ss << "receive batch of " << msgs_.size() << " segments:";
+    for ( const auto& msg : msgs_ ) {
+      ss << " (seqno=" << msg.seqno;
+      if ( msg.SYN ) {
+        ss << " +SYN";
+      }
+      if ( not msg.payload.empty() ) {
+        ss << " payload=\"" << Printer::prettify( msg.payload ) << "\"";
+      }
+      if ( msg.FIN ) {
+        ss << " +FIN";
+      }
+      ss << ")";
+    }
+    return ss.str();
+  }
+};
+
+struct Tick : public Action<ReceiverSet>
+{
+  uint64_t ms_;
+
+  explicit Tick( uint64_t ms ) : ms_( ms ) {}
+  std::string description() const override { return std::to_string( ms_ ) + " ms pass"; }
+  void execute( ReceiverSet& rs ) const override { rs.second.tick( ms_ ); }
+};
+
+struct ExpectAckSent : public Expectation<ReceiverSet>
+{
+  Wrap32 ackno_;
+
+  explicit ExpectAckSent( Wrap32 ackno ) : ackno_( ackno ) {}
+  std::string description() const override { return "ACK sent with ackno = " + to_string( ackno_ ); }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    const auto msg = rs.second.maybe_send( rs.first.first.writer() );
+    if ( not msg.has_value() ) {
+      throw ExpectationViolation( "TCPReceiver was expected to send an ACK, but did not" );
+    }
+    if ( msg->ackno != ackno_ ) {
+      throw ExpectationViolation( "ackno", std::optional { ackno_ }, msg->ackno );
+    }
+  }
+};
+
+struct ExpectNoAck : public Expectation<ReceiverSet>
+{
+  std::string description() const override { return "no ACK sent"; }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    const auto msg = rs.second.maybe_send( rs.first.first.writer() );
+    if ( msg.has_value() ) {
+      throw ExpectationViolation( "TCPReceiver sent an ACK (ackno=" + to_string( msg->ackno )
+                                  + ") although none was due" );
+    }
+  }
+};
+
+struct AckSent : public Action<ReceiverSet>
+{
+  std::string description() const override { return "ACK piggybacked on outgoing data"; }
+  void execute( ReceiverSet& rs ) const override { rs.second.ack_sent( rs.first.first.writer() ); }
+};
@@ -0,0 +1,73 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    TCPConfig config;
+    config.recv_autotune = true;
+    config.recv_min_capacity = 4000;
+    config.recv_max_capacity = 1 << 20;
+    const string full( 1000, 'x' );
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "auto-tuning grows and shrinks the window", 64000, config };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { 4000 } );
+      test.execute( AckSent {} );
+      test.execute( Tick { 100 } );
+
+      // a whole window arrives within one RTT: capacity doubles
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + i * 1000 ).with_data( full ) );
+      }
+      test.execute( ExpectWindow { 4000 } );
+      test.execute( ReadAll { string( 4000, 'x' ) } );
+      test.execute( ExpectWindow { 8000 } );
+      test.execute( AckSent {} );
+
+      // a trickle of data: capacity shrinks, but never behind the right edge already advertised
+      test.execute( Tick { 1000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4001 ).with_data( string( 100, 'y' ) ) );
+      test.execute( ExpectWindow { 7900 } );
+      test.execute( AckSent {} );
+      test.execute( ReadAll { string( 100, 'y' ) } );
+      test.execute( Tick { 1000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4101 ).with_data( string( 100, 'z' ) ) );
+      test.execute( ExpectWindow { 7800 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 4201 } } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "auto-tuning respects the maximum", 64000, config };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      uint64_t offset = 1;
+      for ( uint32_t round = 0; round < 12; round++ ) {
+        test.execute( Tick { 10 } );
+        while ( test.available_capacity() >= full.size() ) {
+          test.execute( SegmentArrives {}.with_seqno( isn + offset ).with_data( full ) );
+          offset += full.size();
+        }
+        test.execute( Pop { UINT32_MAX } );
+      }
+      test.execute( Capacity { config.recv_max_capacity } );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "batch in order", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentsArrive {}
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "ghi" ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 10 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 9 } );
+      test.execute( ReadAll { "abcdefghi" } );
+      test.execute( ExpectWindow { 4000 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "batch with SYN, FIN and out-of-order segments", 4000 };
+      test.execute( SegmentsArrive {}
+                      .with_segment( SegmentArrives {}.with_syn().with_seqno( isn ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "gh" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ij" ).with_fin() )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( BytesPending { 4 } );
+      test.execute( IsClosed { false } );
+      test.execute( SegmentsArrive {}
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "ef" ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 12 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( IsClosed { true } );
+      test.execute( ReadAll { "abcdefghij" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "batch beyond the window", 4 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentsArrive {}
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { 0 } );
+      test.execute( ReadAll { "abcd" } );
+    }
+
+    {
+      // the stream holds the segments' own payload Buffers (or slices of them), not copies
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      ByteStream stream { 4000 };
+      Reassembler reassembler;
+      TCPReceiver receiver;
+      receiver.receive( { Wrap32 { isn }, true, {}, false }, reassembler, stream.writer() );
+      const vector<TCPSenderMessage> burst { { Wrap32 { isn + 1 }, false, string( "abc" ), false },
+                                             { Wrap32 { isn + 4 }, false, string( "def" ), false } };
+      receiver.receive_batch( burst, reassembler, stream.writer() );
+      const vector<TCPSenderMessage> overlap { { Wrap32 { isn + 5 }, false, string( "efg" ), false },
+                                               { Wrap32 { isn + 8 }, false, string( "hi" ), false } };
+      receiver.receive_batch( overlap, reassembler, stream.writer() );
+
+      const vector<const char*> expected { static_cast<string_view>( burst[0].payload ).data(),
+                                           static_cast<string_view>( burst[1].payload ).data(),
+                                           static_cast<string_view>( overlap[0].payload ).data() + 2,
+                                           static_cast<string_view>( overlap[1].payload ).data() };
+      for ( const char* data : expected ) {
+        if ( stream.reader().peek().data() != data ) {
+          throw runtime_error( "receive_batch copied a payload instead of sharing its Buffer" );
+        }
+        stream.reader().pop( stream.reader().peek().size() );
+      }
+      if ( stream.reader().bytes_popped() != 9 ) {
+        throw runtime_error( "receive_batch delivered the wrong number of bytes" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const string full( TCPConfig::MAX_PAYLOAD_SIZE, 'x' );
+    const uint32_t full_len = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "delayed ACK: every second full segment", 64000 };
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 1 } } );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( full ) );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 + full_len ).with_data( full ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 1 + 2 * full_len } } );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 + 2 * full_len ).with_data( full ) );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 + 3 * full_len ).with_data( full ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 1 + 4 * full_len } } );
+      test.execute( ExpectNoAck {} );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "delayed ACK: timeout", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 1 } } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectNoAck {} );
+      test.execute( Tick { TCPConfig::ACK_DELAY_DFLT - 1 } );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectNoAck {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectAckSent { Wrap32 { isn + 9 } } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectNoAck {} );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "delayed ACK: out-of-order and gap-filling", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 9 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 9 } } );
+      test.execute( ExpectNoAck {} );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "delayed ACK: FIN and pure ACKs", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckSent { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) );
+      test.execute( ExpectNoAck {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_fin() );
+      test.execute( ExpectAckSent { Wrap32 { isn + 4 } } );
+      test.execute( ExpectNoAck {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
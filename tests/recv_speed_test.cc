@@ -0,0 +1,107 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+double receive_throughput( const vector<TCPSenderMessage>& segments, // NOLINT(bugprone-easily-swappable-*)
+                           const string& data,
+                           const size_t batch_size )
+{
+  ByteStream stream { TCPConfig::DEFAULT_CAPACITY };
+  Reassembler reassembler;
+  TCPReceiver receiver;
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  const span<const TCPSenderMessage> all { segments };
+  for ( size_t i = 0; i < all.size(); i += batch_size ) {
+    const auto batch = all.subspan( i, min( batch_size, all.size() - i ) );
+    if ( batch_size == 1 ) {
+      receiver.receive( batch.front(), reassembler, stream.writer() );
+    } else {
+      receiver.receive_batch( batch, reassembler, stream.writer() );
+    }
+    while ( stream.reader().bytes_buffered() ) {
+      output_data += stream.reader().peek();
+      stream.reader().pop( output_data.size() - stream.reader().bytes_popped() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( not stream.reader().is_finished() or data != output_data ) {
+    throw runtime_error( "Mismatch between data sent and received" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  return 8 * static_cast<double>( data.size() ) / test_duration.count() / 1e9;
+}
+
+void speed_test( const size_t num_segments, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t batch_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  // Generate the data to be sent
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < num_segments * TCPConfig::MAX_PAYLOAD_SIZE; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  // Split the data into full-sized segments
+  const Wrap32 isn { static_cast<uint32_t>( random_seed ) };
+  vector<TCPSenderMessage> segments;
+  segments.push_back( { isn, true, {}, false } );
+  for ( size_t i = 0; i < data.size(); i += TCPConfig::MAX_PAYLOAD_SIZE ) {
+    const bool last = i + TCPConfig::MAX_PAYLOAD_SIZE >= data.size();
+    segments.push_back( { isn + 1 + i, false, data.substr( i, TCPConfig::MAX_PAYLOAD_SIZE ), last } );
+  }
+
+  const double single_gbps = receive_throughput( segments, data, 1 );
+  const double batch_gbps = receive_throughput( segments, data, batch_size );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCPReceiver with " << num_segments << " segments reached " << fixed << setprecision( 2 )
+       << single_gbps << " Gbit/s one at a time and " << batch_gbps << " Gbit/s in batches of " << batch_size
+       << ".\n";
+
+  debug_output << "             TCPReceiver throughput: " << fixed << setprecision( 2 ) << single_gbps
+               << " Gbit/s (single), " << batch_gbps << " Gbit/s (batch)\n";
+
+  if ( single_gbps < 0.1 or batch_gbps < 0.1 ) {
+    throw runtime_error( "TCPReceiver did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 100000, 16, 1370 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
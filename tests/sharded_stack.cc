@@ -0,0 +1,185 @@
+#include "sharded_stack.hh"
+#include "spsc_queue.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void check_spsc_queue()
+{
+  SPSCQueue<int> queue { 5 };
+  if ( queue.capacity() != 8 ) {
+    throw runtime_error( "SPSCQueue capacity was not rounded up to a power of two" );
+  }
+  for ( int i = 0; i < 8; i++ ) {
+    if ( not queue.try_push( i ) ) {
+      throw runtime_error( "SPSCQueue::try_push failed before the queue was full" );
+    }
+  }
+  int extra = 8;
+  if ( queue.try_push( extra ) ) {
+    throw runtime_error( "SPSCQueue::try_push succeeded on a full queue" );
+  }
+  for ( int i = 0; i < 8; i++ ) {
+    if ( queue.try_pop() != i ) {
+      throw runtime_error( "SPSCQueue did not preserve FIFO order" );
+    }
+  }
+  if ( queue.try_pop() or not queue.empty() ) {
+    throw runtime_error( "SPSCQueue::try_pop returned an item from an empty queue" );
+  }
+
+  // One thread produces, another consumes
+  constexpr uint64_t count = 100000;
+  SPSCQueue<uint64_t> shared { 64 };
+  thread producer { [&] {
+    for ( uint64_t i = 0; i < count; i++ ) {
+      while ( not shared.try_push( i ) ) {
+        this_thread::yield();
+      }
+    }
+  } };
+  for ( uint64_t expected = 0; expected < count; ) {
+    if ( auto item = shared.try_pop() ) {
+      if ( item.value() != expected++ ) {
+        producer.join();
+        throw runtime_error( "SPSCQueue reordered items across threads" );
+      }
+    } else {
+      this_thread::yield();
+    }
+  }
+  producer.join();
+}
+
+// Client connections on this thread talk to an echo server running on a ShardedStack
+void check_echo()
+{
+  constexpr size_t num_shards = 3;
+  constexpr uint16_t num_clients = 48;
+  const TCPConfig config;
+
+  // Transmitted segments come back to this thread through one queue per shard
+  vector<unique_ptr<SPSCQueue<InboundSegment>>> outboxes;
+  for ( size_t i = 0; i < num_shards; i++ ) {
+    outboxes.push_back( make_unique<SPSCQueue<InboundSegment>>( 1024 ) );
+  }
+  auto transmit = [&]( size_t shard, const ConnectionKey& key, TCPMessage message ) {
+    InboundSegment segment { key, std::move( message ) };
+    while ( not outboxes[shard]->try_push( segment ) ) {
+      this_thread::yield();
+    }
+  };
+  auto echo = []( size_t, const ConnectionKey&, TCPConnection& connection ) {
+    string data;
+    read( connection.inbound_reader(), connection.inbound_reader().bytes_buffered(), data );
+    connection.outbound_writer().push( data );
+    if ( connection.inbound_reader().is_finished() ) {
+      connection.outbound_writer().close();
+    }
+  };
+  ShardedStack server { num_shards, config, transmit, echo };
+
+  // The server sees each connection from its own side of the 4-tuple
+  auto server_key = []( uint16_t port ) { return ConnectionKey { 0x0a000001, 0x0a000002, 7, port }; };
+
+  ConnectionTable clients;
+  vector<string> requests;
+  vector<string> replies( num_clients );
+  vector<bool> seen_shard( num_shards );
+  for ( uint16_t port = 0; port < num_clients; port++ ) {
+    TCPConnection& client = clients.open( { 0x0a000002, 0x0a000001, port, 7 }, config );
+    requests.push_back( "hello from port " + to_string( port ) );
+    client.outbound_writer().push( requests.back() );
+    client.outbound_writer().close();
+    seen_shard[server.shard_of( server_key( port ) )] = true;
+  }
+  for ( size_t i = 0; i < num_shards; i++ ) {
+    if ( not seen_shard[i] ) {
+      throw runtime_error( "no connection was steered to shard " + to_string( i ) );
+    }
+  }
+
+  server.start();
+  for ( unsigned int round = 0; round < 100000; round++ ) {
+    size_t done = 0;
+    clients.for_each( [&]( const ConnectionKey& key, TCPConnection& client ) {
+      while ( auto message = client.maybe_send() ) {
+        InboundSegment segment { server_key( key.src_port ), std::move( message.value() ) };
+        while ( not server.deliver( segment ) ) {
+          this_thread::yield();
+        }
+      }
+      string chunk;
+      read( client.inbound_reader(), client.inbound_reader().bytes_buffered(), chunk );
+      replies[key.src_port] += chunk;
+      done += client.inbound_reader().is_finished();
+    } );
+    if ( done == num_clients ) {
+      break;
+    }
+
+    for ( auto& outbox : outboxes ) {
+      while ( auto segment = outbox->try_pop() ) {
+        clients.demux( { segment->key.dst_ip, segment->key.src_ip, segment->key.dst_port, segment->key.src_port },
+                       std::move( segment->message ) );
+      }
+    }
+    this_thread::yield();
+  }
+  server.stop();
+
+  if ( replies != requests ) {
+    throw runtime_error( "echo server did not return every request on its own connection" );
+  }
+  if ( server.segments_processed() == 0 ) {
+    throw runtime_error( "ShardedStack did not count the segments it processed" );
+  }
+}
+
+// A connection that gets no more segments is still served by its retransmission timer
+void check_timers()
+{
+  TCPConfig config;
+  config.rt_timeout = 5;
+  atomic<size_t> transmitted { 0 };
+  ShardedStack server { 1, config, [&]( size_t, const ConnectionKey&, TCPMessage ) { transmitted++; } };
+  server.start();
+
+  // The server's SYN/ACK is never answered, so only its timer can make it send again
+  InboundSegment syn { { 0x0a000001, 0x0a000002, 7, 1000 }, {} };
+  syn.message.sender.SYN = true;
+  if ( not server.deliver( syn ) ) {
+    throw runtime_error( "ShardedStack rejected a segment with an empty queue" );
+  }
+  for ( unsigned int i = 0; i < 2000 and transmitted < 3; i++ ) {
+    this_thread::sleep_for( chrono::milliseconds( 1 ) );
+  }
+  server.stop();
+
+  if ( transmitted < 3 ) {
+    throw runtime_error( "ShardedStack did not retransmit on an otherwise idle connection" );
+  }
+}
+
+int main()
+{
+  try {
+    check_spsc_queue();
+    check_echo();
+    check_timers();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "sharded_stack.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Per-shard counter, padded so shards do not false-share
+struct alignas( 64 ) ShardBytes
+{
+  uint64_t bytes {};
+};
+
+double segment_rate( const vector<InboundSegment>& segments, // NOLINT(bugprone-easily-swappable-*)
+                     const size_t num_shards,
+                     const uint64_t expected_bytes )
+{
+  vector<ShardBytes> received( num_shards );
+  auto consume = [&received]( size_t shard, const ConnectionKey&, TCPConnection& connection ) {
+    Reader& reader = connection.inbound_reader();
+    received[shard].bytes += reader.bytes_buffered();
+    reader.pop( reader.bytes_buffered() );
+  };
+  ShardedStack stack { num_shards, TCPConfig {}, {}, consume };
+  stack.start();
+
+  const auto start_time = steady_clock::now();
+  for ( const auto& original : segments ) {
+    InboundSegment segment = original;
+    while ( not stack.deliver( segment ) ) {
+      this_thread::yield();
+    }
+  }
+  while ( stack.segments_processed() + stack.segments_dropped() < segments.size() ) {
+    this_thread::yield();
+  }
+  const auto stop_time = steady_clock::now();
+  stack.stop();
+
+  uint64_t total_bytes = 0;
+  for ( const auto& shard : received ) {
+    total_bytes += shard.bytes;
+  }
+  if ( stack.segments_dropped() or total_bytes != expected_bytes ) {
+    throw runtime_error( "ShardedStack did not deliver every segment" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  return static_cast<double>( segments.size() ) / test_duration.count();
+}
+
+void speed_test( const size_t num_connections,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t segments_per_conn, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t payload_size )     // NOLINT(bugprone-easily-swappable-parameters)
+{
+  // Each connection opens with a SYN, then sends its payload in order; connections are interleaved
+  const Wrap32 isn { 1370 };
+  const string payload( payload_size, 'x' );
+  vector<InboundSegment> segments;
+  segments.reserve( num_connections * ( segments_per_conn + 1 ) );
+  auto key = []( size_t i ) {
+    return ConnectionKey { 0x0a000001, static_cast<uint32_t>( 0x0b000000 + i ), 80, static_cast<uint16_t>( i ) };
+  };
+  for ( size_t i = 0; i < num_connections; i++ ) {
+    segments.push_back( { key( i ), { { isn, true, {}, false }, { {}, UINT16_MAX } } } );
+  }
+  for ( size_t seg = 0; seg < segments_per_conn; seg++ ) {
+    for ( size_t i = 0; i < num_connections; i++ ) {
+      const TCPSenderMessage data { isn + 1 + seg * payload_size, false, payload, false };
+      segments.push_back( { key( i ), { data, { {}, UINT16_MAX } } } );
+    }
+  }
+  const uint64_t expected_bytes = num_connections * segments_per_conn * payload_size;
+
+  // Leave one core for the thread that steers segments into the shards
+  const size_t max_shards = max( 1U, thread::hardware_concurrency() - 1 );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  double single_rate = 0;
+  for ( size_t shards = 1; shards <= max_shards; shards *= 2 ) {
+    const double rate = segment_rate( segments, shards, expected_bytes );
+    if ( shards == 1 ) {
+      single_rate = rate;
+    }
+
+    cout << "ShardedStack with " << shards << " shard(s): " << fixed << setprecision( 2 ) << rate / 1e6
+         << " M segments/s (" << rate / single_rate << "x one shard).\n";
+    debug_output << "             ShardedStack (" << shards << " shards): " << fixed << setprecision( 2 )
+                 << rate / 1e6 << " M segments/s\n";
+
+    if ( rate < 1e4 ) {
+      throw runtime_error( "ShardedStack did not meet minimum rate of 10k segments/s." );
+    }
+  }
+}
+
+void program_body()
+{
+  speed_test( 4096, 32, 500 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
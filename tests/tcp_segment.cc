@@ -0,0 +1,185 @@
+#include "ipv4_datagram.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Serialize, concatenate and parse again
+TCPSegment round_trip( const TCPSegment& segment )
+{
+  string wire;
+  for ( const auto& b : serialize( segment ) ) {
+    wire.append( static_cast<string_view>( b ) );
+  }
+  if ( wire.size() != segment.header.serialized_length() + segment.payload.front().size() ) {
+    throw runtime_error( "TCPSegment serialized to the wrong length" );
+  }
+  TCPSegment parsed;
+  if ( not parse( parsed, { wire } ) ) {
+    throw runtime_error( "failed to parse serialized segment: " + segment.header.to_string() );
+  }
+  return parsed;
+}
+
+bool same_header( const TCPHeader& a, const TCPHeader& b )
+{
+  return a.sport == b.sport and a.dport == b.dport and a.seqno == b.seqno and a.ackno == b.ackno
+         and a.doff == b.doff and a.urg == b.urg and a.ack == b.ack and a.psh == b.psh and a.rst == b.rst
+         and a.syn == b.syn and a.fin == b.fin and a.win == b.win and a.cksum == b.cksum and a.uptr == b.uptr
+         and a.mss == b.mss and a.window_scale == b.window_scale and a.sack_permitted == b.sack_permitted
+         and a.timestamps == b.timestamps and a.sack_blocks == b.sack_blocks
+         and equal( a.sack.begin(), a.sack.begin() + a.sack_blocks, b.sack.begin() );
+}
+
+void check_round_trips()
+{
+  TCPSegment plain;
+  plain.header = { .sport = 443, .dport = 51000, .seqno = 0xdeadbeef, .ackno = 12345, .ack = true, .win = 512 };
+  plain.payload = { string( "hello" ) };
+
+  TCPSegment timestamped = plain;
+  timestamped.header.psh = true;
+  timestamped.header.timestamps = TCPTimestamps { 1000, 999 };
+
+  TCPSegment syn;
+  syn.header = { .sport = 51000, .dport = 443, .seqno = 1, .syn = true, .win = 65535 };
+  syn.header.mss = 1460;
+  syn.header.window_scale = 7;
+  syn.header.sack_permitted = true;
+  syn.header.timestamps = TCPTimestamps { 42, 0 };
+  syn.payload = { string() };
+
+  TCPSegment sacked = timestamped;
+  sacked.header.sack_blocks = 3;
+  sacked.header.sack = { { { 100, 200 }, { 300, 400 }, { 500, 600 }, {} } };
+
+  for ( auto segment : { plain, timestamped, syn, sacked } ) {
+    segment.header.doff = segment.header.serialized_length() / 4;
+    const TCPSegment parsed = round_trip( segment );
+    if ( not same_header( parsed.header, segment.header ) ) {
+      throw runtime_error( "TCPHeader did not survive a round trip: " + segment.header.to_string() + " became "
+                           + parsed.header.to_string() );
+    }
+  }
+
+  // Four SACK blocks plus timestamps do not fit in the options space
+  sacked.header.sack_blocks = 4;
+  sacked.header.doff = sacked.header.serialized_length() / 4;
+  try {
+    serialize( sacked );
+    throw runtime_error( "TCPHeader serialized more than 40 bytes of options" );
+  } catch ( const runtime_error& e ) {
+    if ( string( e.what() ).find( "options do not fit" ) == string::npos ) {
+      throw;
+    }
+  }
+}
+
+void check_foreign_layout()
+{
+  // A SYN as Linux lays it out: MSS, SACK-permitted + timestamps, NOP + window scale, plus an unknown option
+  const string wire { "\xc6\x38\x01\xbb"
+                      "\x00\x00\x00\x01"
+                      "\x00\x00\x00\x00"
+                      "\xb0\x02\xff\xff"
+                      "\x00\x00\x00\x00"
+                      "\x02\x04\x05\xb4"
+                      "\x04\x02\x08\x0a\x00\x00\x00\x2a\x00\x00\x00\x00"
+                      "\x01\x03\x03\x07"
+                      "\xfe\x04\xab\xcd",
+                      44 };
+  TCPSegment segment;
+  if ( not parse( segment, { wire } ) ) {
+    throw runtime_error( "failed to parse Linux-style SYN" );
+  }
+  const TCPHeader& h = segment.header;
+  if ( h.sport != 50744 or h.dport != 443 or not h.syn or h.ack or h.mss != 1460 or h.window_scale != 7
+       or not h.sack_permitted or h.timestamps != TCPTimestamps { 42, 0 } or h.sack_blocks ) {
+    throw runtime_error( "Linux-style SYN parsed incorrectly: " + h.to_string() );
+  }
+
+  // Malformed headers
+  string short_doff = wire;
+  short_doff[12] = 0x40;
+  string bad_option_length = wire;
+  bad_option_length[21] = 0x05;
+  string runs_past_end = wire;
+  runs_past_end[41] = 0x06;
+  for ( const auto& bad : { short_doff, bad_option_length, runs_past_end, wire.substr( 0, 30 ) } ) {
+    if ( parse( segment, { bad } ) ) {
+      throw runtime_error( "parsed a malformed TCP header" );
+    }
+  }
+}
+
+void check_checksum()
+{
+  TCPSegment segment;
+  segment.header = { .sport = 80, .dport = 40000, .seqno = 7, .ackno = 9, .ack = true, .win = 1000 };
+  segment.header.timestamps = TCPTimestamps { 5, 6 };
+  segment.payload = { string( "odd-length payload" ).substr( 1 ) };
+
+  IPv4Header ip;
+  ip.src = 0x0a000001;
+  ip.dst = 0x0a000002;
+  ip.len = IPv4Header::LENGTH + segment.header.serialized_length() + segment.payload.front().size();
+  segment.compute_checksum( ip.pseudo_checksum() );
+
+  vector<Buffer> wire = serialize( segment );
+  if ( not TCPSegment::checksum_ok( ip.pseudo_checksum(), wire ) ) {
+    throw runtime_error( "TCP checksum did not verify" );
+  }
+
+  // The same bytes, split at an odd offset
+  string flat;
+  for ( const auto& b : wire ) {
+    flat.append( static_cast<string_view>( b ) );
+  }
+  if ( not TCPSegment::checksum_ok( ip.pseudo_checksum(), { flat.substr( 0, 13 ), flat.substr( 13 ) } ) ) {
+    throw runtime_error( "TCP checksum did not verify across an odd split" );
+  }
+
+  flat.back() ^= 1;
+  if ( TCPSegment::checksum_ok( ip.pseudo_checksum(), { flat } ) ) {
+    throw runtime_error( "TCP checksum verified a corrupted segment" );
+  }
+}
+
+void check_messages()
+{
+  TCPMessage message;
+  message.sender = { Wrap32 { 1234 }, false, string( "data" ), true };
+  message.receiver = { Wrap32 { 99 }, 4096 };
+
+  const TCPSegment segment = TCPSegment::from_message( message, 1, 2 );
+  if ( not segment.header.ack or not segment.header.fin or segment.header.syn or segment.header.win != 4096 ) {
+    throw runtime_error( "TCPSegment::from_message set the wrong header fields" );
+  }
+  const TCPMessage back = round_trip( segment ).to_message();
+  if ( not( back.sender.seqno == message.sender.seqno ) or not back.sender.FIN or back.sender.SYN
+       or static_cast<string_view>( back.sender.payload ) != "data" or back.receiver.ackno != Wrap32 { 99 }
+       or back.receiver.window_size != 4096 ) {
+    throw runtime_error( "TCPMessage did not survive conversion to and from a TCPSegment" );
+  }
+}
+
+int main()
+{
+  try {
+    check_round_trips();
+    check_foreign_layout();
+    check_checksum();
+    check_messages();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
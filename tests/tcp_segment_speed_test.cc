@@ -0,0 +1,102 @@
+#include "tcp_segment.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+void speed_test( const string& name, TCPSegment segment, const size_t repetitions )
+{
+  segment.header.doff = segment.header.serialized_length() / 4;
+
+  // Serialize
+  size_t bytes = 0;
+  const auto serialize_start = steady_clock::now();
+  for ( size_t i = 0; i < repetitions; ++i ) {
+    segment.header.seqno++;
+    bytes += serialize( segment ).size();
+  }
+  const auto serialize_stop = steady_clock::now();
+
+  // Parse (the header is one contiguous buffer, as it would be off the wire)
+  string wire;
+  for ( const auto& b : serialize( segment ) ) {
+    wire.append( static_cast<string_view>( b ) );
+  }
+  const vector<Buffer> input { wire };
+  TCPSegment parsed;
+  size_t ok = 0;
+  const auto parse_start = steady_clock::now();
+  for ( size_t i = 0; i < repetitions; ++i ) {
+    ok += parse( parsed, input );
+  }
+  const auto parse_stop = steady_clock::now();
+
+  if ( ok != repetitions or parsed.header.timestamps != segment.header.timestamps or bytes == 0 ) {
+    throw runtime_error( "TCPSegment failed to parse its own output" );
+  }
+
+  const auto serialize_duration = duration_cast<duration<double>>( serialize_stop - serialize_start );
+  const auto parse_duration = duration_cast<duration<double>>( parse_stop - parse_start );
+  const double serialize_rate = static_cast<double>( repetitions ) / serialize_duration.count();
+  const double parse_rate = static_cast<double>( repetitions ) / parse_duration.count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCPSegment (" << name << ", " << segment.header.serialized_length() << "-byte header): serialize "
+       << fixed << setprecision( 2 ) << serialize_rate / 1e6 << " M/s, parse " << parse_rate / 1e6 << " M/s.\n";
+
+  debug_output << "             TCPSegment " << name << ": " << fixed << setprecision( 2 ) << serialize_rate / 1e6
+               << " M serialized/s, " << parse_rate / 1e6 << " M parsed/s\n";
+
+  if ( serialize_rate < 1e5 or parse_rate < 1e5 ) {
+    throw runtime_error( "TCPSegment did not meet minimum rate of 100k segments/s." );
+  }
+}
+
+void program_body()
+{
+  constexpr size_t repetitions = 500000;
+
+  TCPSegment plain;
+  plain.header = { .sport = 443, .dport = 51000, .seqno = 1, .ackno = 12345, .ack = true, .win = 512 };
+  plain.payload = { string( 1000, 'x' ) };
+  speed_test( "no options", plain, repetitions );
+
+  TCPSegment timestamped = plain;
+  timestamped.header.timestamps = TCPTimestamps { 1000, 999 };
+  speed_test( "timestamps", timestamped, repetitions );
+
+  TCPSegment sacked = timestamped;
+  sacked.header.sack_blocks = 2;
+  sacked.header.sack = { { { 100, 200 }, { 300, 400 }, {}, {} } };
+  speed_test( "timestamps + SACK", sacked, repetitions );
+
+  TCPSegment syn;
+  syn.header = { .sport = 51000, .dport = 443, .seqno = 1, .syn = true, .win = 65535 };
+  syn.header.mss = 1460;
+  syn.header.window_scale = 7;
+  syn.header.sack_permitted = true;
+  syn.header.timestamps = TCPTimestamps { 42, 0 };
+  syn.payload = { string() };
+  speed_test( "SYN options", syn, repetitions );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
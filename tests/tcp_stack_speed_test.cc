@@ -0,0 +1,181 @@
+#include "link_emulator.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t HEADER_BYTES = 40;              // IPv4 + TCP headers, without options
+static constexpr uint64_t MAX_TRANSFER_MS = 600 * 1000; // give up on a transfer after 10 minutes
+
+struct TransferResult
+{
+  uint64_t completion_ms {};
+  uint64_t payload_bytes_sent {}; // including retransmissions
+};
+
+// Send `data` from one TCPConnection to another over a pair of emulated links, one millisecond at a time
+TransferResult transfer( const string& data, LinkConfig link )
+{
+  const TCPConfig config;
+  TCPConnection client { config };
+  TCPConnection server { config };
+  LinkEmulator<TCPMessage> uplink { link };
+  link.seed = ~link.seed;
+  LinkEmulator<TCPMessage> downlink { link };
+
+  server.outbound_writer().close();
+  size_t written = 0;
+  string received;
+  TransferResult result;
+
+  for ( uint64_t ms = 0; ms < MAX_TRANSFER_MS; ms++ ) {
+    Writer& writer = client.outbound_writer();
+    if ( written < data.size() ) {
+      const size_t len = min( data.size() - written, writer.available_capacity() );
+      writer.push( data.substr( written, len ) );
+      written += len;
+      if ( written == data.size() ) {
+        writer.close();
+      }
+    }
+
+    while ( auto msg = client.maybe_send() ) {
+      const size_t len = msg->sender.payload.size();
+      result.payload_bytes_sent += len;
+      uplink.send( std::move( msg.value() ), HEADER_BYTES + len );
+    }
+    while ( auto msg = server.maybe_send() ) {
+      downlink.send( std::move( msg.value() ), HEADER_BYTES );
+    }
+
+    uplink.advance( 1000 );
+    downlink.advance( 1000 );
+    while ( auto msg = uplink.receive() ) {
+      server.receive( std::move( msg.value() ) );
+    }
+    while ( auto msg = downlink.receive() ) {
+      client.receive( std::move( msg.value() ) );
+    }
+
+    string chunk;
+    read( server.inbound_reader(), server.inbound_reader().bytes_buffered(), chunk );
+    received += chunk;
+    if ( server.inbound_reader().is_finished() ) {
+      if ( received != data ) {
+        throw runtime_error( "Mismatch between data sent and received" );
+      }
+      result.completion_ms = ms + 1;
+      return result;
+    }
+
+    client.tick( 1 );
+    server.tick( 1 );
+  }
+
+  throw runtime_error( "transfer did not finish within " + to_string( MAX_TRANSFER_MS ) + " ms" );
+}
+
+void benchmark( const string& name, // NOLINT(bugprone-easily-swappable-parameters)
+                LinkConfig link,
+                const size_t num_transfers,
+                const size_t transfer_size )
+{
+  // Generate the data to be sent
+  const string data = [&] {
+    default_random_engine rd { link.seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < transfer_size; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  vector<uint64_t> completion_ms;
+  uint64_t total_ms = 0;
+  uint64_t total_sent = 0;
+  const uint64_t first_seed = link.seed;
+  for ( size_t i = 0; i < num_transfers; ++i ) {
+    link.seed = first_seed + i;
+    const TransferResult result = transfer( data, link );
+    completion_ms.push_back( result.completion_ms );
+    total_ms += result.completion_ms;
+    total_sent += result.payload_bytes_sent;
+  }
+
+  sort( completion_ms.begin(), completion_ms.end() );
+  auto percentile = [&]( const size_t p ) { return completion_ms.at( ( completion_ms.size() - 1 ) * p / 100 ); };
+
+  const auto total_bytes = static_cast<double>( num_transfers * transfer_size );
+  const double goodput_mbps = 8 * total_bytes / ( static_cast<double>( total_ms ) / 1000 ) / 1e6;
+  const double retx_ratio = static_cast<double>( total_sent ) / total_bytes - 1;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << setw( 8 ) << name << ": goodput " << fixed << setprecision( 2 ) << setw( 7 ) << goodput_mbps
+       << " Mbit/s, retransmitted " << setw( 5 ) << 100 * retx_ratio << "%, completion p50/p90/p99 "
+       << percentile( 50 ) << "/" << percentile( 90 ) << "/" << percentile( 99 ) << " ms\n";
+
+  debug_output << "             TCP over " << name << " link: " << fixed << setprecision( 2 ) << goodput_mbps
+               << " Mbit/s goodput\n";
+
+  if ( goodput_mbps <= 0 ) {
+    throw runtime_error( "TCP made no progress over the " + name + " link." );
+  }
+}
+
+void program_body()
+{
+  constexpr size_t transfers = 20;
+  constexpr size_t size = 256 * 1024;
+
+  LinkConfig clean;
+  clean.bandwidth_bps = 100'000'000;
+  clean.delay_us = 5000;
+  clean.queue_limit = 128;
+  clean.seed = 1370;
+  benchmark( "clean", clean, transfers, size );
+
+  LinkConfig lossy = clean;
+  lossy.jitter_us = 1000;
+  lossy.loss = 0.01;
+  benchmark( "lossy", lossy, transfers, size );
+
+  LinkConfig bursty = clean;
+  bursty.burst_enter = 0.005;
+  bursty.burst_exit = 0.3;
+  bursty.burst_loss = 0.5;
+  benchmark( "bursty", bursty, transfers, size );
+
+  LinkConfig reordering = clean;
+  reordering.reorder = 0.02;
+  reordering.reorder_us = 3000;
+  benchmark( "reorder", reordering, transfers, size );
+
+  LinkConfig narrow = clean;
+  narrow.bandwidth_bps = 10'000'000;
+  narrow.queue_limit = 16;
+  benchmark( "narrow", narrow, transfers, size );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "buffer.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+// Unused Storage blocks, kept per thread so that allocating one takes no lock. A block freed on
+// another thread than the one that allocated it simply joins the freeing thread's pool.
+struct Buffer::Pool
+{
+  static constexpr size_t MAX_FREE = 4096;
+
+  Storage* free {};
+  size_t count {};
+
+  Pool() = default;
+  Pool( const Pool& other ) = delete;
+  Pool& operator=( const Pool& other ) = delete;
+
+  ~Pool()
+  {
+    while ( free ) {
+      delete exchange( free, free->next_free );
+    }
+  }
+};
+
+Buffer::Pool& Buffer::pool()
+{
+  thread_local Pool the_pool;
+  return the_pool;
+}
+
+Buffer::Storage* Buffer::allocate( string&& str )
+{
+  Pool& p = pool();
+  Storage* storage = p.free;
+  if ( storage ) {
+    p.free = storage->next_free;
+    p.count--;
+    storage->next_free = nullptr;
+    storage->refs = 1;
+  } else {
+    storage = new Storage;
+  }
+  storage->str = move( str );
+  return storage;
+}
+
+void Buffer::deallocate( Storage* storage )
+{
+  Pool& p = pool();
+  if ( p.count >= Pool::MAX_FREE ) {
+    delete storage;
+    return;
+  }
+  storage->str = string(); // give back the string's memory, but keep the block
+  storage->next_free = p.free;
+  p.free = storage;
+  p.count++;
+}
+
+string& Buffer::materialize()
+{
+  if ( not storage_ ) {
+    storage_ = allocate( {} );
+    offset_ = 0;
+    length_ = WHOLE;
+  } else if ( length_ != WHOLE ) {
+    // A slice gets a string of its own, so that changes to it can't reach the rest of the shared storage
+    string copy { static_cast<string_view>( *this ) };
+    drop();
+    storage_ = allocate( move( copy ) );
+    offset_ = 0;
+    length_ = WHOLE;
+  }
+  return storage_->str;
+}
+
+Buffer Buffer::slice( const size_t offset, const size_t len ) const
+{
+  const size_t size = this->size();
+  if ( offset > size ) {
+    throw out_of_range( "Buffer::slice: offset past end of buffer" );
+  }
+  if ( offset == 0 and len >= size ) {
+    return *this;
+  }
+  return { storage_, offset_ + offset, min( len, size - offset ) };
+}
@@ -1,23 +1,134 @@
 #pragma once
 
-#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 
+// A reference-counted, immutable-by-convention string that is cheap to copy and to slice.
+// Copies and slices share one pool-allocated Storage block (the string plus an intrusive
+// reference count), so neither copying nor slicing a Buffer allocates.
 class Buffer
 {
-  std::shared_ptr<std::string> buffer_;
+#if defined( MINNOW_SINGLE_THREADED )
+  using RefCount = uint32_t; // Buffers never cross threads, so skip the atomic read-modify-writes
+#else
+  using RefCount = std::atomic<uint32_t>;
+#endif
+
+  struct Storage
+  {
+    std::string str {};
+    RefCount refs { 1 };
+    Storage* next_free {}; // link in the per-thread pool of unused blocks
+  };
+
+  static constexpr size_t WHOLE = -1; // length_ of a Buffer that views its whole (possibly growing) string
+
+  Storage* storage_ {}; // nullptr for an empty Buffer
+  size_t offset_ {};
+  size_t length_ { WHOLE };
+
+  struct Pool;
+  static Pool& pool();
+  static Storage* allocate( std::string&& str );
+  static void deallocate( Storage* storage );
+
+  void retain() const
+  {
+    if ( storage_ ) {
+#if defined( MINNOW_SINGLE_THREADED )
+      ++storage_->refs;
+#else
+      storage_->refs.fetch_add( 1, std::memory_order_relaxed );
+#endif
+    }
+  }
+
+  void drop()
+  {
+    if ( not storage_ ) {
+      return;
+    }
+#if defined( MINNOW_SINGLE_THREADED )
+    const bool last = --storage_->refs == 0;
+#else
+    const bool last = storage_->refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1;
+#endif
+    if ( last ) {
+      deallocate( storage_ );
+    }
+    storage_ = nullptr;
+  }
+
+  // Make this Buffer the sole view of its whole string (copying out a slice if necessary)
+  std::string& materialize();
+
+  Buffer( Storage* storage, size_t offset, size_t length )
+    : storage_( storage ), offset_( offset ), length_( length )
+  {
+    retain();
+  }
 
 public:
   // NOLINTBEGIN(*-explicit-*)
 
-  Buffer( std::string str = {} ) : buffer_( make_shared<std::string>( std::move( str ) ) ) {}
-  operator std::string_view() const { return *buffer_; }
-  operator std::string&() { return *buffer_; }
+  Buffer( std::string str = {} ) : storage_( str.empty() ? nullptr : allocate( std::move( str ) ) ) {}
+  operator std::string_view() const
+  {
+    if ( not storage_ ) {
+      return {};
+    }
+    const std::string_view whole { storage_->str };
+    return length_ == WHOLE ? whole : whole.substr( std::min( offset_, whole.size() ), length_ );
+  }
+  operator std::string&() { return materialize(); }
 
   // NOLINTEND(*-explicit-*)
 
-  std::string&& release() { return std::move( *buffer_ ); }
-  size_t size() const { return buffer_->size(); }
-  size_t length() const { return buffer_->length(); }
-  bool empty() const { return buffer_->empty(); }
+  Buffer( const Buffer& other ) : storage_( other.storage_ ), offset_( other.offset_ ), length_( other.length_ )
+  {
+    retain();
+  }
+
+  Buffer( Buffer&& other ) noexcept
+    : storage_( std::exchange( other.storage_, nullptr ) ), offset_( other.offset_ ), length_( other.length_ )
+  {}
+
+  Buffer& operator=( const Buffer& other )
+  {
+    if ( this != &other ) {
+      other.retain();
+      drop();
+      storage_ = other.storage_;
+      offset_ = other.offset_;
+      length_ = other.length_;
+    }
+    return *this;
+  }
+
+  Buffer& operator=( Buffer&& other ) noexcept
+  {
+    if ( this != &other ) {
+      drop();
+      storage_ = std::exchange( other.storage_, nullptr );
+      offset_ = other.offset_;
+      length_ = other.length_;
+    }
+    return *this;
+  }
+
+  ~Buffer() { drop(); }
+
+  std::string&& release() { return std::move( materialize() ); }
+  size_t size() const { return static_cast<std::string_view>( *this ).size(); }
+  size_t length() const { return size(); }
+  bool empty() const { return size() == 0; }
+
+  // A view of `len` bytes starting at `offset` (clamped to the end, like std::string::substr), sharing this
+  // Buffer's storage. Throws std::out_of_range if offset > size().
+  Buffer slice( size_t offset, size_t len = WHOLE ) const;
 };
@@ -0,0 +1,194 @@
+#include "checksum.hh"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// Each kernel sums `len` bytes (an even number) as 16-bit words in the machine's native byte order
+// and folds the result to 16 bits. The one's-complement sum commutes with byte swapping, so on a
+// little-endian machine swapping the result gives the sum of the big-endian words (RFC 1071).
+using Kernel = uint16_t ( * )( const char* data, size_t len );
+
+uint16_t fold( uint64_t sum )
+{
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + ( sum & 0xffff );
+  }
+  return sum;
+}
+
+uint16_t sum_scalar( const char* data, size_t len )
+{
+  // Add each 64-bit word as two 32-bit halves, so the 64-bit accumulator cannot overflow
+  uint64_t sum = 0;
+  for ( ; len >= 8; data += 8, len -= 8 ) {
+    uint64_t word {};
+    memcpy( &word, data, sizeof( word ) );
+    sum += ( word & 0xffffffff ) + ( word >> 32 );
+  }
+  for ( ; len >= 2; data += 2, len -= 2 ) {
+    uint16_t word {};
+    memcpy( &word, data, sizeof( word ) );
+    sum += word;
+  }
+  return fold( sum );
+}
+
+#if defined( __x86_64__ )
+
+// SSE2 is part of x86-64, so this kernel is always available there
+uint16_t sum_sse2( const char* data, size_t len )
+{
+  // Widen each 32-bit lane to 64 bits before adding, as in the scalar kernel
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = zero;
+  for ( ; len >= 16; data += 16, len -= 16 ) {
+    const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data ) );
+    acc = _mm_add_epi64( acc, _mm_unpacklo_epi32( v, zero ) );
+    acc = _mm_add_epi64( acc, _mm_unpackhi_epi32( v, zero ) );
+  }
+
+  array<uint64_t, 2> lanes {};
+  _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes.data() ), acc );
+  return fold( static_cast<uint64_t>( fold( lanes[0] ) ) + fold( lanes[1] ) + sum_scalar( data, len ) );
+}
+
+__attribute__( ( target( "avx2" ) ) ) uint16_t sum_avx2( const char* data, size_t len )
+{
+  // Two independent accumulators, 64 bytes per iteration
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc0 = zero;
+  __m256i acc1 = zero;
+  for ( ; len >= 64; data += 64, len -= 64 ) {
+    const __m256i v0 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data ) );
+    const __m256i v1 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + 32 ) );
+    acc0 = _mm256_add_epi64( acc0, _mm256_unpacklo_epi32( v0, zero ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_unpackhi_epi32( v0, zero ) );
+    acc0 = _mm256_add_epi64( acc0, _mm256_unpacklo_epi32( v1, zero ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_unpackhi_epi32( v1, zero ) );
+  }
+
+  if ( len >= 32 ) {
+    const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data ) );
+    acc0 = _mm256_add_epi64( acc0, _mm256_unpacklo_epi32( v, zero ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_unpackhi_epi32( v, zero ) );
+    data += 32;
+    len -= 32;
+  }
+
+  array<uint64_t, 4> lanes {};
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes.data() ), _mm256_add_epi64( acc0, acc1 ) );
+
+  // GCC doesn't clear the upper halves of the YMM registers on return from a target("avx2") function, and
+  // leaving them dirty makes the caller's (non-VEX) SSE code pay a state-transition penalty
+  _mm256_zeroupper();
+
+  uint64_t sum = sum_scalar( data, len );
+  for ( const uint64_t lane : lanes ) {
+    sum += fold( lane );
+  }
+  return fold( sum );
+}
+
+#endif
+
+Kernel kernel_function( const ChecksumKernel kernel )
+{
+  switch ( kernel ) {
+#if defined( __x86_64__ )
+    case ChecksumKernel::AVX2:
+      return sum_avx2;
+    case ChecksumKernel::SSE2:
+      return sum_sse2;
+#endif
+    default:
+      return sum_scalar;
+  }
+}
+
+ChecksumKernel best_kernel()
+{
+#if defined( __x86_64__ )
+  return __builtin_cpu_supports( "avx2" ) ? ChecksumKernel::AVX2 : ChecksumKernel::SSE2;
+#else
+  return ChecksumKernel::Scalar;
+#endif
+}
+
+struct Dispatch
+{
+  ChecksumKernel kernel;
+  Kernel sum;
+};
+
+Dispatch& dispatch()
+{
+  static Dispatch active { best_kernel(), kernel_function( best_kernel() ) };
+  return active;
+}
+
+} // namespace
+
+void InternetChecksum::add( string_view data )
+{
+  if ( data.empty() ) {
+    return;
+  }
+
+  // An odd number of bytes so far: this piece's first byte is the low half of a word
+  if ( parity_ ) {
+    sum_ += static_cast<uint8_t>( data.front() );
+    data.remove_prefix( 1 );
+    parity_ = false;
+  }
+
+  uint16_t partial = dispatch().sum( data.data(), data.size() & ~static_cast<size_t>( 1 ) );
+  if constexpr ( endian::native == endian::little ) {
+    partial = __builtin_bswap16( partial );
+  }
+  sum_ += partial;
+
+  // ... and a trailing odd byte is the high half of the next word
+  if ( data.size() % 2 ) {
+    sum_ += static_cast<uint16_t>( static_cast<uint8_t>( data.back() ) << 8 );
+    parity_ = true;
+  }
+}
+
+ChecksumKernel InternetChecksum::kernel()
+{
+  return dispatch().kernel;
+}
+
+bool InternetChecksum::kernel_supported( const ChecksumKernel kernel )
+{
+  switch ( kernel ) {
+    case ChecksumKernel::Scalar:
+      return true;
+#if defined( __x86_64__ )
+    case ChecksumKernel::SSE2:
+      return true;
+    case ChecksumKernel::AVX2:
+      return __builtin_cpu_supports( "avx2" );
+#endif
+    default:
+      return false;
+  }
+}
+
+void InternetChecksum::use_kernel( const ChecksumKernel kernel )
+{
+  if ( not kernel_supported( kernel ) ) {
+    throw runtime_error( "InternetChecksum: checksum kernel not supported on this CPU" );
+  }
+  dispatch() = { kernel, kernel_function( kernel ) };
+}
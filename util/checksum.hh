@@ -4,32 +4,33 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Implementations of the bulk one's-complement sum behind InternetChecksum::add()
+enum class ChecksumKernel
+{
+  Scalar, // 64-bit words
+  SSE2,   // 128-bit vectors
+  AVX2,   // 256-bit vectors
+};
+
 //! The internet checksum algorithm
 class InternetChecksum
 {
 private:
-  uint32_t sum_;
-  bool parity_ {};
+  uint64_t sum_;
+  bool parity_ {}; // has an odd number of bytes been added so far?
 
 public:
   explicit InternetChecksum( const uint32_t sum = 0 ) : sum_( sum ) {}
-  void add( std::string_view data )
-  {
-    for ( const uint8_t i : data ) {
-      uint16_t val = i;
-      if ( not parity_ ) {
-        val <<= 8;
-      }
-      sum_ += val;
-      parity_ = !parity_;
-    }
-  }
+
+  // Add bytes to the sum. The data may be split into pieces of any length (odd or even).
+  void add( std::string_view data );
 
   uint16_t value() const
   {
-    uint32_t ret = sum_;
+    uint64_t ret = sum_;
 
     while ( ret > 0xffff ) {
       ret = ( ret >> 16 ) + static_cast<uint16_t>( ret );
@@ -44,4 +45,30 @@ public:
       add( x );
     }
   }
+
+  // RFC 1624 incremental update (eqn. 3): the new checksum after one 16-bit word of the checksummed data
+  // changes from `old_word` to `new_word`, without re-summing the rest of the data.
+  static uint16_t update( const uint16_t cksum, const uint16_t old_word, const uint16_t new_word )
+  {
+    uint32_t sum = static_cast<uint16_t>( ~cksum );
+    sum += static_cast<uint16_t>( ~old_word );
+    sum += new_word;
+    sum = ( sum >> 16 ) + ( sum & 0xffff );
+    sum += sum >> 16;
+    return ~sum;
+  }
+
+  // The same, for a 32-bit field (e.g. an address in the TCP pseudo-header)
+  static uint16_t update32( const uint16_t cksum, const uint32_t old_word, const uint32_t new_word )
+  {
+    const uint16_t high = update( cksum, old_word >> 16, new_word >> 16 );
+    return update( high, static_cast<uint16_t>( old_word ), static_cast<uint16_t>( new_word ) );
+  }
+
+  // The kernel add() uses. By default this is the fastest one the CPU supports.
+  static ChecksumKernel kernel();
+  static bool kernel_supported( ChecksumKernel kernel );
+
+  // Switch kernels (for testing and benchmarking). Throws if the CPU does not support it.
+  static void use_kernel( ChecksumKernel kernel );
 };
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// An open-addressing hash map with linear probing.
+//
+// All entries live in a single flat array, so a lookup is one hash plus (usually) one cache line.
+// Erasing uses backward-shift deletion, so the table never accumulates tombstones. The table
+// doubles whenever it becomes more than half full. Pointers returned by find() and insert() are
+// invalidated by any later insert().
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class FlatHashMap
+{
+  struct Slot
+  {
+    Key key {};
+    Value value {};
+    bool used {};
+  };
+
+  std::vector<Slot> slots_;
+  size_t size_ {};
+  size_t mask_;
+  Hash hash_ {};
+
+  size_t home( const Key& key ) const { return hash_( key ) & mask_; }
+
+  size_t locate( const Key& key ) const
+  {
+    size_t i = home( key );
+    while ( slots_[i].used and not( slots_[i].key == key ) ) {
+      i = ( i + 1 ) & mask_;
+    }
+    return i;
+  }
+
+  void rehash( size_t slot_count )
+  {
+    std::vector<Slot> old = std::exchange( slots_, std::vector<Slot>( slot_count ) );
+    mask_ = slot_count - 1;
+    for ( auto& slot : old ) {
+      if ( slot.used ) {
+        slots_[locate( slot.key )] = std::move( slot );
+      }
+    }
+  }
+
+public:
+  explicit FlatHashMap( size_t capacity = 16 )
+    : slots_( std::bit_ceil( std::max<size_t>( capacity * 2, 16 ) ) ), mask_( slots_.size() - 1 )
+  {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Make room for `count` entries without rehashing
+  void reserve( size_t count )
+  {
+    if ( count * 2 > slots_.size() ) {
+      rehash( std::bit_ceil( count * 2 ) );
+    }
+  }
+
+  Value* find( const Key& key )
+  {
+    Slot& slot = slots_[locate( key )];
+    return slot.used ? &slot.value : nullptr;
+  }
+
+  const Value* find( const Key& key ) const
+  {
+    const Slot& slot = slots_[locate( key )];
+    return slot.used ? &slot.value : nullptr;
+  }
+
+  // Insert `value` under `key` unless the key is already present.
+  // Returns the stored value and whether the insertion took place.
+  std::pair<Value*, bool> insert( const Key& key, Value value )
+  {
+    if ( ( size_ + 1 ) * 2 > slots_.size() ) {
+      rehash( slots_.size() * 2 );
+    }
+    Slot& slot = slots_[locate( key )];
+    if ( slot.used ) {
+      return { &slot.value, false };
+    }
+    slot.key = key;
+    slot.value = std::move( value );
+    slot.used = true;
+    ++size_;
+    return { &slot.value, true };
+  }
+
+  bool erase( const Key& key )
+  {
+    size_t hole = locate( key );
+    if ( not slots_[hole].used ) {
+      return false;
+    }
+
+    // Shift later members of the probe sequence back so lookups never hit a gap
+    for ( size_t next = ( hole + 1 ) & mask_; slots_[next].used; next = ( next + 1 ) & mask_ ) {
+      const size_t want = home( slots_[next].key );
+      const bool stays = hole <= next ? ( hole < want and want <= next ) : ( hole < want or want <= next );
+      if ( not stays ) {
+        slots_[hole] = std::move( slots_[next] );
+        hole = next;
+      }
+    }
+    slots_[hole] = Slot {};
+    --size_;
+    return true;
+  }
+
+  void clear()
+  {
+    for ( auto& slot : slots_ ) {
+      slot = Slot {};
+    }
+    size_ = 0;
+  }
+
+  // Call `f( key, value )` for every entry
+  template<typename F>
+  void for_each( F&& f )
+  {
+    for ( auto& slot : slots_ ) {
+      if ( slot.used ) {
+        f( std::as_const( slot.key ), slot.value );
+      }
+    }
+  }
+};
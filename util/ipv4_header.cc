@@ -11,6 +11,16 @@ using namespace std;
 // Parse from string.
 void IPv4Header::parse( Parser& parser )
 {
+  // Verify checksum over the raw header bytes (a correct header, including its checksum field, sums to 0xffff)
+  if ( parser.verify_checksums() and not parser.input().empty() ) {
+    const uint64_t header_length = static_cast<uint64_t>( parser.input().peek().front() & 0x0f ) * 4;
+    InternetChecksum check;
+    parser.peek( header_length, [&check]( std::string_view piece ) { check.add( piece ); } );
+    if ( check.value() != 0 ) {
+      parser.set_error();
+    }
+  }
+
   uint8_t first_byte {};
   parser.integer( first_byte );
   ver = first_byte >> 4;    // version
@@ -40,13 +50,6 @@ void IPv4Header::parse( Parser& parser )
   }
 
   parser.remove_prefix( static_cast<uint64_t>( hlen ) * 4 - IPv4Header::LENGTH );
-
-  // Verify checksum
-  const uint16_t given_cksum = cksum;
-  compute_checksum();
-  if ( cksum != given_cksum ) {
-    parser.set_error();
-  }
 }
 
 // Serialize the IPv4Header (does not recompute the checksum)
@@ -112,6 +115,26 @@ void IPv4Header::compute_checksum()
   cksum = check.value();
 }
 
+// TTL and protocol share one 16-bit word of the header
+void IPv4Header::decrement_ttl()
+{
+  const uint16_t old_word = ( static_cast<uint16_t>( ttl ) << 8 ) | proto;
+  --ttl;
+  cksum = InternetChecksum::update( cksum, old_word, ( static_cast<uint16_t>( ttl ) << 8 ) | proto );
+}
+
+void IPv4Header::set_src( const uint32_t new_src )
+{
+  cksum = InternetChecksum::update32( cksum, src, new_src );
+  src = new_src;
+}
+
+void IPv4Header::set_dst( const uint32_t new_dst )
+{
+  cksum = InternetChecksum::update32( cksum, dst, new_dst );
+  dst = new_dst;
+}
+
 std::string IPv4Header::to_string() const
 {
   stringstream ss {};
@@ -57,6 +57,13 @@ struct IPv4Header
   // Set checksum to correct value
   void compute_checksum();
 
+  // Decrement the TTL, updating the checksum incrementally (RFC 1624) instead of recomputing it
+  void decrement_ttl();
+
+  // Rewrite an address, updating the checksum incrementally
+  void set_src( uint32_t new_src );
+  void set_dst( uint32_t new_dst );
+
   // Return a string containing a header in human-readable format
   std::string to_string() const;
 
@@ -0,0 +1,53 @@
+#include "packet_buffer.hh"
+
+#include <utility>
+
+using namespace std;
+
+string& PacketBuffer::scratch()
+{
+  thread_local string bytes;
+  return bytes;
+}
+
+PacketBuffer::PacketBuffer( const size_t headroom, const size_t payload_capacity ) : head_( headroom )
+{
+  storage_.reserve( headroom + payload_capacity );
+  storage_.resize( headroom );
+}
+
+span<char> PacketBuffer::prepend( const size_t len )
+{
+  if ( len > head_ ) {
+    // Out of headroom: move the packet back, leaving the default headroom in front of the new bytes
+    const size_t grow = len - head_ + DEFAULT_HEADROOM;
+    storage_.insert( 0, grow, '\0' );
+    head_ += grow;
+  }
+  head_ -= len;
+  return { storage_.data() + head_, len };
+}
+
+void PacketBuffer::append( const string_view data )
+{
+  storage_.append( data );
+}
+
+void PacketBuffer::append( const vector<Buffer>& data )
+{
+  for ( const auto& x : data ) {
+    append( static_cast<string_view>( x ) );
+  }
+}
+
+Buffer PacketBuffer::release()
+{
+  // Leave the bytes where they are: a packet with headroom left over becomes a slice of the storage
+  const size_t head = exchange( head_, 0 );
+  Buffer whole { std::move( storage_ ) };
+  storage_.clear();
+  if ( head == 0 ) {
+    return whole;
+  }
+  return whole.slice( head );
+}
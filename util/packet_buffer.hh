@@ -0,0 +1,56 @@
+#pragma once
+
+#include "buffer.hh"
+#include "parser.hh"
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A packet under construction, held in one contiguous allocation with reserved headroom in front
+// (like a Linux sk_buff). Each layer prepends its header in place, so a frame needs neither a fresh
+// buffer per header nor a gather of separate Buffers on the way out.
+class PacketBuffer
+{
+  std::string storage_ {};
+  size_t head_ {}; // offset of the packet's first byte within storage_
+
+  // Reusable space to serialize a header into before it is copied into the headroom
+  static std::string& scratch();
+
+public:
+  // Enough for Ethernet + IPv4 with options + TCP with options
+  static constexpr size_t DEFAULT_HEADROOM = 128;
+
+  explicit PacketBuffer( size_t headroom = DEFAULT_HEADROOM, size_t payload_capacity = 0 );
+
+  size_t headroom() const { return head_; }
+  size_t size() const { return storage_.size() - head_; }
+  std::string_view data() const { return std::string_view { storage_ }.substr( head_ ); }
+
+  // Make room for `len` bytes in front of the packet and return them. This reallocates only if the
+  // headroom has run out.
+  std::span<char> prepend( size_t len );
+
+  // Add bytes at the end of the packet
+  void append( std::string_view data );
+  void append( const std::vector<Buffer>& data );
+
+  // Serialize a header (e.g. a TCPHeader, IPv4Header or EthernetHeader) in front of the packet
+  template<class T>
+  void push_header( const T& header )
+  {
+    Serializer serializer { std::move( scratch() ) };
+    header.serialize( serializer );
+    scratch() = serializer.release_bytes();
+    std::memcpy( prepend( scratch().size() ).data(), scratch().data(), scratch().size() );
+    scratch().clear();
+  }
+
+  // Hand the finished packet (without the headroom) to a Buffer. Unused headroom stays in front of it
+  // (the Buffer is a slice of the storage), so the packet is never moved.
+  Buffer release();
+};
@@ -3,33 +3,53 @@
 #include "buffer.hh"
 
 #include <algorithm>
+#include <bit>
 #include <concepts>
 #include <cstdint>
 #include <cstring>
-#include <deque>
 #include <numeric>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 class Serializer;
 
 class Parser
 {
+  // A cursor over a borrowed sequence of Buffers (which must outlive it)
   class BufferList
   {
-    uint64_t size_ {};
-    std::deque<Buffer> buffer_ {};
-    uint64_t skip_ {};
+    std::span<const Buffer> buffers_ {};
+    size_t index_ {};             // the buffer the cursor is in
+    std::string_view current_ {}; // what remains of that buffer (never empty unless at the end)
+    uint64_t size_ {};            // bytes remaining in total
+
+    // Move the cursor to the start of the next non-empty buffer
+    void next_buffer()
+    {
+      current_ = {};
+      while ( current_.empty() and index_ < buffers_.size() ) {
+        if ( ++index_ < buffers_.size() ) {
+          current_ = buffers_[index_];
+        }
+      }
+    }
 
   public:
     // NOLINTNEXTLINE(*-explicit-*)
-    BufferList( const std::vector<Buffer>& buffers )
+    BufferList( std::span<const Buffer> buffers ) : buffers_( buffers )
     {
-      for ( const auto& x : buffers ) {
-        append( x );
+      for ( const auto& x : buffers_ ) {
+        size_ += x.size();
+      }
+      if ( not buffers_.empty() ) {
+        current_ = buffers_.front();
+        if ( current_.empty() ) {
+          next_buffer();
+        }
       }
     }
 
@@ -39,41 +59,49 @@ class Parser
 
     std::string_view peek() const
     {
-      if ( buffer_.empty() ) {
+      if ( empty() ) {
         throw std::runtime_error( "peek on empty BufferList" );
       }
-      return std::string_view { buffer_.front() }.substr( skip_ );
+      return current_;
     }
 
-    void remove_prefix( uint64_t len )
+    // Call `visit` on successive pieces of the first `len` bytes, without removing them
+    template<class F>
+    void peek( uint64_t len, F&& visit ) const
     {
-      while ( len and not buffer_.empty() ) {
-        const uint64_t to_pop_now = std::min( len, peek().size() );
-        skip_ += to_pop_now;
-        len -= to_pop_now;
-        size_ -= to_pop_now;
-        if ( skip_ == buffer_.front().size() ) {
-          buffer_.pop_front();
-          skip_ = 0;
+      for ( size_t i = index_; len and i < buffers_.size(); ++i ) {
+        const std::string_view whole = i == index_ ? current_ : std::string_view { buffers_[i] };
+        const std::string_view piece = whole.substr( 0, len );
+        if ( not piece.empty() ) {
+          visit( piece );
+          len -= piece.size();
         }
       }
     }
 
+    void remove_prefix( uint64_t len )
+    {
+      len = std::min( len, size_ );
+      size_ -= len;
+      while ( len >= current_.size() and not current_.empty() ) {
+        len -= current_.size();
+        next_buffer();
+      }
+      current_.remove_prefix( len );
+    }
+
     void dump_all( std::vector<Buffer>& out )
     {
       out.clear();
       if ( empty() ) {
         return;
       }
-      std::string first_str = std::move( buffer_.front() );
-      if ( skip_ ) {
-        first_str = first_str.substr( skip_ );
-      }
-      out.emplace_back( std::move( first_str ) );
-      buffer_.pop_front();
-      for ( auto&& x : buffer_ ) {
-        out.emplace_back( std::move( x ) );
-      }
+      const Buffer& first = buffers_[index_];
+      out.push_back( first.slice( first.size() - current_.size() ) );
+      out.insert( out.end(), buffers_.begin() + static_cast<ptrdiff_t>( index_ ) + 1, buffers_.end() );
+      index_ = buffers_.size();
+      current_ = {};
+      size_ = 0;
     }
 
     void dump_all( Buffer& out )
@@ -90,16 +118,24 @@ class Parser
         out.release().append( s );
       }
     }
-
-    void append( Buffer str )
-    {
-      size_ += str.size();
-      buffer_.push_back( std::move( str ) );
-    }
   };
 
   BufferList input_;
   bool error_ {};
+  bool verify_checksums_ { true };
+
+  template<std::unsigned_integral T>
+  static T byteswap( const T val )
+  {
+    if constexpr ( sizeof( T ) == 2 ) {
+      return __builtin_bswap16( val );
+    } else if constexpr ( sizeof( T ) == 4 ) {
+      return __builtin_bswap32( val );
+    } else {
+      static_assert( sizeof( T ) == 8 );
+      return __builtin_bswap64( val );
+    }
+  }
 
   void check_size( const size_t size )
   {
@@ -109,7 +145,11 @@ class Parser
   }
 
 public:
-  explicit Parser( const std::vector<Buffer>& input ) : input_( input ) {}
+  // The Parser borrows `input`, which must outlive it
+  explicit Parser( std::span<const Buffer> input, const bool verify_checksums = true )
+    : input_( input ), verify_checksums_( verify_checksums )
+  {}
+  Parser( std::vector<Buffer>&& input, bool verify_checksums = true ) = delete;
 
   const BufferList& input() const { return input_; }
 
@@ -117,6 +157,20 @@ public:
   void set_error() { error_ = true; }
   void remove_prefix( size_t n ) { input_.remove_prefix( n ); }
 
+  // Should headers check their checksums? (Not if a lower layer, e.g. the NIC, already has.)
+  bool verify_checksums() const { return verify_checksums_; }
+
+  // Call `visit` on the next `len` bytes of input, in one or more pieces, without consuming them
+  template<class F>
+  void peek( size_t len, F&& visit )
+  {
+    check_size( len );
+    if ( has_error() ) {
+      return;
+    }
+    input_.peek( len, std::forward<F>( visit ) );
+  }
+
   template<std::unsigned_integral T>
   void integer( T& out )
   {
@@ -125,24 +179,38 @@ public:
       return;
     }
 
-    if constexpr ( sizeof( T ) == 1 ) {
-      out = static_cast<uint8_t>( input_.peek().front() );
-      input_.remove_prefix( 1 );
-      return;
-    } else {
-      out = static_cast<T>( 0 );
-      for ( size_t i = 0; i < sizeof( T ); i++ ) {
-        out <<= 8;
-        out |= static_cast<uint8_t>( input_.peek().front() );
-        input_.remove_prefix( 1 );
+    // Fast path: the whole integer is in the current buffer
+    const std::string_view view = input_.peek();
+    if ( view.size() >= sizeof( T ) ) {
+      std::memcpy( &out, view.data(), sizeof( T ) );
+      if constexpr ( sizeof( T ) > 1 and std::endian::native == std::endian::little ) {
+        out = byteswap( out );
       }
+      input_.remove_prefix( sizeof( T ) );
+      return;
+    }
+
+    // Slow path: the integer straddles a buffer boundary
+    out = static_cast<T>( 0 );
+    for ( size_t i = 0; i < sizeof( T ); i++ ) {
+      out <<= 8;
+      out |= static_cast<uint8_t>( input_.peek().front() );
+      input_.remove_prefix( 1 );
     }
   }
 
   void string( std::span<char> out )
   {
     check_size( out.size() );
-    if ( has_error() ) {
+    if ( has_error() or out.empty() ) {
+      return;
+    }
+
+    // Fast path: the whole string is in the current buffer
+    const std::string_view current = input_.peek();
+    if ( current.size() >= out.size() ) {
+      std::memcpy( out.data(), current.data(), out.size() );
+      input_.remove_prefix( out.size() );
       return;
     }
 
@@ -202,6 +270,15 @@ public:
     flush();
     return output_;
   }
+
+  // The bytes written so far, as one string (only if no Buffers have been added)
+  std::string release_bytes()
+  {
+    if ( not output_.empty() ) {
+      throw std::runtime_error( "Serializer::release_bytes(): output is not contiguous" );
+    }
+    return std::move( buffer_ );
+  }
 };
 
 // Helper to serialize any object (without constructing a Serializer of the caller's own)
@@ -0,0 +1,228 @@
+#include "pcap.hh"
+#include "exception.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t MAGIC_MICROSECONDS = 0xa1b2c3d4;
+constexpr uint32_t MAGIC_NANOSECONDS = 0xa1b23c4d;
+constexpr size_t FILE_HEADER_LENGTH = 24;
+constexpr size_t RECORD_HEADER_LENGTH = 16;
+constexpr uint32_t MAX_RECORD_LENGTH = 1 << 24; // anything longer means the file is corrupt
+
+template<class T>
+void put( string& out, const T value )
+{
+  array<char, sizeof( T )> bytes {};
+  memcpy( bytes.data(), &value, sizeof( T ) );
+  out.append( bytes.data(), bytes.size() );
+}
+
+} // namespace
+
+PcapReader::PcapReader( const string& path )
+  : file_( CheckSystemCall( "open " + path, ::open( path.c_str(), O_RDONLY | O_CLOEXEC ) ) ) // NOLINT(*-vararg)
+{
+  if ( not fill( FILE_HEADER_LENGTH ) ) {
+    throw runtime_error( "PcapReader: " + path + " is too short to be a pcap file" );
+  }
+  const string_view header = string_view { chunk_ }.substr( 0, FILE_HEADER_LENGTH );
+
+  uint32_t magic {};
+  memcpy( &magic, header.data(), sizeof( magic ) );
+  const uint32_t swapped_magic = __builtin_bswap32( magic );
+  if ( magic == MAGIC_MICROSECONDS or magic == MAGIC_NANOSECONDS ) {
+    swapped_ = false;
+  } else if ( swapped_magic == MAGIC_MICROSECONDS or swapped_magic == MAGIC_NANOSECONDS ) {
+    swapped_ = true;
+  } else {
+    throw runtime_error( "PcapReader: " + path + " is not a pcap file" );
+  }
+  nanoseconds_ = field( header, 0 ) == MAGIC_NANOSECONDS;
+  snaplen_ = field( header, 16 );
+  if ( const uint32_t linktype = field( header, 20 ); linktype != LINKTYPE_ETHERNET ) {
+    throw runtime_error( "PcapReader: " + path + " has link type " + to_string( linktype ) + ", not Ethernet" );
+  }
+  pos_ = FILE_HEADER_LENGTH;
+}
+
+uint32_t PcapReader::field( const string_view bytes, const size_t offset ) const
+{
+  uint32_t value {};
+  memcpy( &value, bytes.data() + offset, sizeof( value ) );
+  return swapped_ ? __builtin_bswap32( value ) : value;
+}
+
+bool PcapReader::fill( const size_t len )
+{
+  const string_view unread = string_view { chunk_ }.substr( pos_ );
+  if ( unread.size() >= len ) {
+    return true;
+  }
+
+  // Start a new chunk with the bytes left over from the old one, then read until it is full
+  string next { unread };
+  size_t filled = next.size();
+  next.resize( max( CHUNK_SIZE, len ) );
+  while ( filled < next.size() ) {
+    const ssize_t bytes_read = ::read( file_.fd_num(), next.data() + filled, next.size() - filled );
+    if ( bytes_read < 0 ) {
+      throw unix_error { "read" };
+    }
+    if ( bytes_read == 0 ) {
+      break;
+    }
+    filled += bytes_read;
+  }
+  next.resize( filled );
+
+  chunk_ = Buffer { std::move( next ) };
+  pos_ = 0;
+  return filled >= len;
+}
+
+optional<PcapRecord> PcapReader::next()
+{
+  if ( not fill( RECORD_HEADER_LENGTH ) ) {
+    if ( pos_ < chunk_.size() ) {
+      throw runtime_error( "PcapReader: truncated record header" );
+    }
+    return {};
+  }
+
+  const string_view header = string_view { chunk_ }.substr( pos_, RECORD_HEADER_LENGTH );
+  const uint64_t seconds = field( header, 0 );
+  const uint64_t fraction = field( header, 4 );
+  const uint32_t captured_length = field( header, 8 );
+  PcapRecord record;
+  record.timestamp_ns = seconds * 1'000'000'000 + ( nanoseconds_ ? fraction : fraction * 1000 );
+  record.original_length = field( header, 12 );
+  if ( captured_length > MAX_RECORD_LENGTH ) {
+    throw runtime_error( "PcapReader: record of " + to_string( captured_length ) + " bytes" );
+  }
+  pos_ += RECORD_HEADER_LENGTH;
+
+  if ( not fill( captured_length ) ) {
+    throw runtime_error( "PcapReader: truncated record" );
+  }
+  record.data = chunk_.slice( pos_, captured_length );
+  pos_ += captured_length;
+  ++records_;
+  return record;
+}
+
+PcapWriter::PcapWriter( const string& path, const uint32_t snaplen )
+  : file_( CheckSystemCall( "open " + path,
+                            ::open( path.c_str(), // NOLINT(*-vararg)
+                                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                    S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH ) ) )
+  , snaplen_( snaplen )
+{
+  buffer_.reserve( FLUSH_SIZE + snaplen );
+  put<uint32_t>( buffer_, MAGIC_NANOSECONDS );
+  put<uint16_t>( buffer_, 2 ); // version 2.4
+  put<uint16_t>( buffer_, 4 );
+  put<int32_t>( buffer_, 0 );  // timestamps are UTC
+  put<uint32_t>( buffer_, 0 ); // accuracy of timestamps
+  put<uint32_t>( buffer_, snaplen_ );
+  put<uint32_t>( buffer_, PcapReader::LINKTYPE_ETHERNET );
+}
+
+PcapWriter::~PcapWriter()
+{
+  try {
+    flush();
+  } catch ( const exception& e ) {
+    // don't throw an exception from the destructor
+    cerr << "Exception destructing PcapWriter: " << e.what() << endl;
+  }
+}
+
+void PcapWriter::write( const EthernetFrame& frame, const uint64_t timestamp_ns )
+{
+  write( serialize( frame ), timestamp_ns );
+}
+
+void PcapWriter::write( const span<const Buffer> bytes, const uint64_t timestamp_ns )
+{
+  size_t length = 0;
+  for ( const auto& b : bytes ) {
+    length += b.size();
+  }
+  const uint32_t captured_length = min<size_t>( length, snaplen_ );
+
+  put<uint32_t>( buffer_, timestamp_ns / 1'000'000'000 );
+  put<uint32_t>( buffer_, timestamp_ns % 1'000'000'000 );
+  put<uint32_t>( buffer_, captured_length );
+  put<uint32_t>( buffer_, length );
+  size_t remaining = captured_length;
+  for ( const auto& b : bytes ) {
+    const string_view piece = string_view { b }.substr( 0, remaining );
+    buffer_.append( piece );
+    remaining -= piece.size();
+  }
+  ++records_;
+
+  if ( buffer_.size() >= FLUSH_SIZE ) {
+    flush();
+  }
+}
+
+void PcapWriter::flush()
+{
+  string_view pending = buffer_;
+  while ( not pending.empty() ) {
+    pending.remove_prefix( file_.write( pending ) );
+  }
+  buffer_.clear();
+}
+
+ReplayStats replay( PcapReader& reader,
+                    const function<void( const EthernetFrame& )>& deliver,
+                    const function<void( uint64_t )>& tick,
+                    const ReplayPace pace )
+{
+  ReplayStats stats;
+  optional<uint64_t> first_ns;
+  uint64_t ticked_ms = 0;
+  const auto start = chrono::steady_clock::now();
+
+  while ( auto record = reader.next() ) {
+    if ( not first_ns ) {
+      first_ns = record->timestamp_ns;
+    }
+    // Timestamps aren't always in order (e.g. in merged captures); time never goes backwards
+    const uint64_t elapsed_ns = record->timestamp_ns - min( record->timestamp_ns, *first_ns );
+
+    if ( pace == ReplayPace::Recorded ) {
+      this_thread::sleep_until( start + chrono::nanoseconds( elapsed_ns ) );
+    }
+    if ( tick and elapsed_ns / 1'000'000 > ticked_ms ) {
+      tick( elapsed_ns / 1'000'000 - ticked_ms );
+      ticked_ms = elapsed_ns / 1'000'000;
+    }
+
+    const vector<Buffer> data { std::move( record->data ) };
+    EthernetFrame frame;
+    if ( not parse( frame, data ) ) {
+      ++stats.malformed;
+      continue;
+    }
+    deliver( frame );
+    ++stats.frames;
+    stats.bytes += data.front().size();
+  }
+  return stats;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "buffer.hh"
+#include "ethernet_frame.hh"
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One packet from a capture file
+struct PcapRecord
+{
+  uint64_t timestamp_ns {};    // capture time, since the epoch
+  uint32_t original_length {}; // length on the wire (data is shorter if the capture was truncated)
+  Buffer data {};              // the captured bytes
+};
+
+// Reads a classic pcap file of Ethernet frames (either byte order, microsecond or nanosecond timestamps).
+//
+// The file is read in 1 MiB chunks, and each record's data is a slice of the chunk it was read into, so
+// reading a record copies nothing (but keeps its chunk alive for as long as the record's data is).
+class PcapReader
+{
+  static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+  FileDescriptor file_;
+  Buffer chunk_ {}; // the bytes read most recently
+  size_t pos_ {};   // the first byte of chunk_ not yet returned
+  bool swapped_ {}; // was the file written with the other byte order?
+  bool nanoseconds_ {};
+  uint32_t snaplen_ {};
+  uint64_t records_ {};
+
+  // Make at least `len` unread bytes available in chunk_ (false if the file ends first)
+  bool fill( size_t len );
+  uint32_t field( std::string_view bytes, size_t offset ) const;
+
+public:
+  static constexpr uint32_t LINKTYPE_ETHERNET = 1;
+
+  // Throws if the file can't be opened or isn't a pcap capture of Ethernet frames
+  explicit PcapReader( const std::string& path );
+
+  // The next record, or empty at the end of the file. Throws if the file is truncated or corrupt.
+  std::optional<PcapRecord> next();
+
+  uint64_t records() const { return records_; }
+  uint32_t snaplen() const { return snaplen_; }
+};
+
+// Writes a pcap file of Ethernet frames, with nanosecond timestamps.
+//
+// Records are gathered in a 64 KiB buffer and written out a buffer at a time, so tapping every frame an
+// interface sends (see NetworkInterface::set_capture) costs a memcpy per frame rather than a system call.
+class PcapWriter
+{
+  static constexpr size_t FLUSH_SIZE = 1 << 16;
+
+  FileDescriptor file_;
+  std::string buffer_ {};
+  uint32_t snaplen_;
+  uint64_t records_ {};
+
+public:
+  // Create (or truncate) the file at `path`. Frames longer than `snaplen` are truncated.
+  explicit PcapWriter( const std::string& path, uint32_t snaplen = 262144 );
+  ~PcapWriter();
+
+  PcapWriter( const PcapWriter& other ) = delete;
+  PcapWriter& operator=( const PcapWriter& other ) = delete;
+
+  void write( const EthernetFrame& frame, uint64_t timestamp_ns );
+  void write( std::span<const Buffer> bytes, uint64_t timestamp_ns );
+
+  // Write out everything buffered so far
+  void flush();
+
+  uint64_t records() const { return records_; }
+};
+
+struct ReplayStats
+{
+  uint64_t frames {};    // frames delivered
+  uint64_t bytes {};     // bytes of the frames delivered
+  uint64_t malformed {}; // records that couldn't be parsed as Ethernet frames (and were skipped)
+};
+
+enum class ReplayPace
+{
+  Maximum,  // deliver frames as fast as possible
+  Recorded, // sleep between frames to reproduce the recorded gaps in real time
+};
+
+// Feed every frame in a capture to `deliver` (e.g. NetworkInterface::recv_frame, or the recv_frame of one
+// of a Router's interfaces followed by Router::route). Whatever the pace, `tick` (if given) is told how
+// many milliseconds of recorded time have passed before each frame, so timers run as they did when the
+// capture was taken.
+ReplayStats replay( PcapReader& reader,
+                    const std::function<void( const EthernetFrame& )>& deliver,
+                    const std::function<void( uint64_t ms_since_last_tick )>& tick = {},
+                    ReplayPace pace = ReplayPace::Maximum );
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// A bounded, lock-free queue for exactly one producer thread and one consumer thread.
+//
+// The producer only writes `tail_` and the consumer only writes `head_`, so each side needs one
+// atomic load of the other's index (acquire) and one store of its own (release) per operation.
+// The two indices live on separate cache lines so the threads do not false-share, and each side
+// keeps a cached copy of the other's index to avoid touching that line on every call.
+template<typename T>
+class SPSCQueue
+{
+  static constexpr size_t cache_line = 64;
+
+  std::vector<std::optional<T>> slots_;
+  size_t mask_;
+
+  alignas( cache_line ) std::atomic<size_t> head_ { 0 }; // next slot to pop (written by consumer)
+  size_t cached_tail_ { 0 };                              // consumer's last view of tail_
+
+  alignas( cache_line ) std::atomic<size_t> tail_ { 0 }; // next slot to push (written by producer)
+  size_t cached_head_ { 0 };                              // producer's last view of head_
+
+public:
+  explicit SPSCQueue( size_t capacity )
+    : slots_( std::bit_ceil( std::max<size_t>( capacity, 2 ) ) ), mask_( slots_.size() - 1 )
+  {}
+
+  // Producer side: returns false (and leaves `item` untouched) if the queue is full
+  bool try_push( T& item )
+  {
+    const size_t tail = tail_.load( std::memory_order_relaxed );
+    if ( tail - cached_head_ == slots_.size() ) {
+      cached_head_ = head_.load( std::memory_order_acquire );
+      if ( tail - cached_head_ == slots_.size() ) {
+        return false;
+      }
+    }
+    slots_[tail & mask_].emplace( std::move( item ) );
+    tail_.store( tail + 1, std::memory_order_release );
+    return true;
+  }
+
+  // Consumer side: returns empty optional if the queue is empty
+  std::optional<T> try_pop()
+  {
+    const size_t head = head_.load( std::memory_order_relaxed );
+    if ( head == cached_tail_ ) {
+      cached_tail_ = tail_.load( std::memory_order_acquire );
+      if ( head == cached_tail_ ) {
+        return {};
+      }
+    }
+    std::optional<T> item = std::move( slots_[head & mask_] );
+    slots_[head & mask_].reset();
+    head_.store( head + 1, std::memory_order_release );
+    return item;
+  }
+
+  // Approximate when called from a thread other than the producer or consumer
+  size_t size() const { return tail_.load( std::memory_order_acquire ) - head_.load( std::memory_order_acquire ); }
+  bool empty() const { return size() == 0; }
+  size_t capacity() const { return slots_.size(); }
+};
@@ -14,9 +14,18 @@ public:
   static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr uint16_t ACK_DELAY_DFLT = 200;   //!< Default delayed-ACK timeout is 200 milliseconds
+
+  static constexpr size_t MIN_RECV_CAPACITY = 4000;    //!< Smallest receive capacity chosen by auto-tuning
+  static constexpr size_t MAX_RECV_CAPACITY = 1 << 22; //!< Largest receive capacity chosen by auto-tuning
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
+  uint16_t ack_delay = ACK_DELAY_DFLT;     //!< Longest time an ACK may be held back, in milliseconds (0 = never)
+
+  bool recv_autotune = false;                   //!< Adapt receive capacity to the measured bandwidth-delay product
+  size_t recv_min_capacity = MIN_RECV_CAPACITY; //!< Lower limit for the auto-tuned receive capacity
+  size_t recv_max_capacity = MAX_RECV_CAPACITY; //!< Upper limit for the auto-tuned receive capacity
   std::optional<Wrap32> fixed_isn {};
 };
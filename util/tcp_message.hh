@@ -0,0 +1,19 @@
+#pragma once
+
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+
+/*
+ * The TCPMessage structure is one TCP segment as exchanged between two peers. It carries both
+ * directions of the connection at once:
+ *
+ * 1) The sender half: the seqno, SYN/FIN flags and payload from this peer's TCPSender.
+ *
+ * 2) The receiver half: the ackno and window size from this peer's TCPReceiver.
+ */
+
+struct TCPMessage
+{
+  TCPSenderMessage sender {};
+  TCPReceiverMessage receiver {};
+};
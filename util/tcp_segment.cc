@@ -0,0 +1,301 @@
+#include "tcp_segment.hh"
+#include "checksum.hh"
+
+#include <span>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+uint16_t load16( const array<char, TCPHeader::MAX_OPTIONS_LENGTH>& raw, size_t i )
+{
+  const auto hi = static_cast<uint8_t>( raw.at( i ) );
+  const auto lo = static_cast<uint8_t>( raw.at( i + 1 ) );
+  return static_cast<uint16_t>( hi << 8 | lo );
+}
+
+uint32_t load32( const array<char, TCPHeader::MAX_OPTIONS_LENGTH>& raw, size_t i )
+{
+  return static_cast<uint32_t>( load16( raw, i ) ) << 16 | load16( raw, i + 2 );
+}
+
+} // namespace
+
+// Options are laid out the way most stacks send them, so each one (with its NOP padding) is a
+// whole number of 32-bit words: MSS (4), NOP+WS (4), SACK-permitted+TS or NOP+NOP+TS (12),
+// NOP+NOP+SACK-permitted if there is no TS (4), NOP+NOP+SACK blocks (4 + 8n).
+uint64_t TCPHeader::options_length() const
+{
+  uint64_t len = 0;
+  len += mss ? 4 : 0;
+  len += window_scale ? 4 : 0;
+  len += timestamps ? 12 : ( sack_permitted ? 4 : 0 );
+  len += sack_blocks ? 4 + 8 * static_cast<uint64_t>( sack_blocks ) : 0;
+  return len;
+}
+
+void TCPHeader::parse( Parser& parser )
+{
+  parser.integer( sport );
+  parser.integer( dport );
+  parser.integer( seqno );
+  parser.integer( ackno );
+
+  uint8_t offset_byte {};
+  parser.integer( offset_byte );
+  doff = offset_byte >> 4; // data offset
+
+  uint8_t flags {};
+  parser.integer( flags );
+  urg = static_cast<bool>( flags & 0x20 );
+  ack = static_cast<bool>( flags & 0x10 );
+  psh = static_cast<bool>( flags & 0x08 );
+  rst = static_cast<bool>( flags & 0x04 );
+  syn = static_cast<bool>( flags & 0x02 );
+  fin = static_cast<bool>( flags & 0x01 );
+
+  parser.integer( win );
+  parser.integer( cksum );
+  parser.integer( uptr );
+
+  if ( doff < LENGTH / 4 ) {
+    parser.set_error();
+    return;
+  }
+
+  parse_options( parser, static_cast<uint64_t>( doff ) * 4 - LENGTH );
+}
+
+void TCPHeader::parse_options( Parser& parser, const uint64_t length )
+{
+  mss.reset();
+  window_scale.reset();
+  sack_permitted = false;
+  timestamps.reset();
+  sack_blocks = 0;
+
+  if ( length == 0 or parser.has_error() ) {
+    return;
+  }
+
+  array<char, MAX_OPTIONS_LENGTH> raw {};
+  parser.string( span { raw.data(), length } );
+  if ( parser.has_error() ) {
+    return;
+  }
+
+  // Fast path: most segments on an established connection carry only NOP, NOP, timestamps
+  if ( length == 12 and load32( raw, 0 ) == 0x0101080a ) {
+    timestamps = TCPTimestamps { load32( raw, 4 ), load32( raw, 8 ) };
+    return;
+  }
+
+  size_t i = 0;
+  while ( i < length ) {
+    const uint8_t kind = raw.at( i );
+    if ( kind == OPT_EOL ) {
+      break;
+    }
+    if ( kind == OPT_NOP ) {
+      i++;
+      continue;
+    }
+
+    // every other option has a length byte that covers the kind and length bytes themselves
+    if ( i + 1 >= length ) {
+      parser.set_error();
+      return;
+    }
+    const uint8_t len = raw.at( i + 1 );
+    if ( len < 2 or i + len > length ) {
+      parser.set_error();
+      return;
+    }
+
+    bool ok = true;
+    switch ( kind ) {
+      case OPT_MSS:
+        ok = len == 4;
+        mss = ok ? optional { load16( raw, i + 2 ) } : nullopt;
+        break;
+      case OPT_WINDOW_SCALE:
+        ok = len == 3;
+        window_scale = ok ? optional { static_cast<uint8_t>( raw.at( i + 2 ) ) } : nullopt;
+        break;
+      case OPT_SACK_PERMITTED:
+        ok = len == 2;
+        sack_permitted = ok;
+        break;
+      case OPT_TIMESTAMPS:
+        ok = len == 10;
+        timestamps = ok ? optional { TCPTimestamps { load32( raw, i + 2 ), load32( raw, i + 6 ) } } : nullopt;
+        break;
+      case OPT_SACK:
+        ok = ( len - 2U ) % 8 == 0 and ( len - 2U ) / 8 <= MAX_SACK_BLOCKS;
+        sack_blocks = ok ? ( len - 2U ) / 8 : 0;
+        for ( size_t b = 0; b < sack_blocks; b++ ) {
+          sack.at( b ) = { load32( raw, i + 2 + 8 * b ), load32( raw, i + 6 + 8 * b ) };
+        }
+        break;
+      default: // unknown options are skipped
+        break;
+    }
+    if ( not ok ) {
+      parser.set_error();
+      return;
+    }
+    i += len;
+  }
+}
+
+// Serialize the TCPHeader (does not recompute the checksum)
+void TCPHeader::serialize( Serializer& serializer ) const
+{
+  // consistency checks
+  const uint64_t opts_len = options_length();
+  if ( opts_len > MAX_OPTIONS_LENGTH ) {
+    throw runtime_error( "TCPHeader: options do not fit in " + std::to_string( MAX_OPTIONS_LENGTH ) + " bytes" );
+  }
+  if ( static_cast<uint64_t>( doff ) * 4 != LENGTH + opts_len ) {
+    throw runtime_error( "TCPHeader: doff does not match the length of the options" );
+  }
+
+  serializer.integer( sport );
+  serializer.integer( dport );
+  serializer.integer( seqno );
+  serializer.integer( ackno );
+
+  const uint8_t offset_byte = doff << 4;
+  serializer.integer( offset_byte );
+
+  const uint8_t flags = ( urg ? 0x20U : 0 ) | ( ack ? 0x10U : 0 ) | ( psh ? 0x08U : 0 ) | ( rst ? 0x04U : 0 )
+                        | ( syn ? 0x02U : 0 ) | ( fin ? 0x01U : 0 );
+  serializer.integer( flags );
+
+  serializer.integer( win );
+  serializer.integer( cksum );
+  serializer.integer( uptr );
+
+  // Every option below starts with a full 32-bit word of kind/length (and NOP padding) bytes
+  if ( mss ) {
+    serializer.integer( 0x02040000U | mss.value() );
+  }
+  if ( window_scale ) {
+    serializer.integer( 0x01030300U | window_scale.value() );
+  }
+  if ( timestamps ) {
+    serializer.integer( sack_permitted ? 0x0402080aU : 0x0101080aU );
+    serializer.integer( timestamps->value );
+    serializer.integer( timestamps->echo_reply );
+  } else if ( sack_permitted ) {
+    serializer.integer( 0x01010402U );
+  }
+  if ( sack_blocks ) {
+    serializer.integer( 0x01010500U | ( 2U + 8U * sack_blocks ) );
+    for ( size_t b = 0; b < sack_blocks; b++ ) {
+      serializer.integer( sack.at( b ).left );
+      serializer.integer( sack.at( b ).right );
+    }
+  }
+}
+
+string TCPHeader::to_string() const
+{
+  stringstream ss {};
+  ss << "sport=" << sport << ", dport=" << dport << ", seqno=" << seqno;
+  if ( ack ) {
+    ss << ", ackno=" << ackno;
+  }
+  ss << ", win=" << win << ", flags=" << ( urg ? "U" : "" ) << ( ack ? "A" : "" ) << ( psh ? "P" : "" )
+     << ( rst ? "R" : "" ) << ( syn ? "S" : "" ) << ( fin ? "F" : "" );
+  if ( mss ) {
+    ss << ", mss=" << mss.value();
+  }
+  if ( window_scale ) {
+    ss << ", wscale=" << +window_scale.value();
+  }
+  if ( sack_permitted ) {
+    ss << ", sackOK";
+  }
+  if ( timestamps ) {
+    ss << ", TS val " << timestamps->value << " ecr " << timestamps->echo_reply;
+  }
+  for ( size_t b = 0; b < sack_blocks; b++ ) {
+    ss << ", sack " << sack.at( b ).left << ":" << sack.at( b ).right;
+  }
+  return ss.str();
+}
+
+void TCPSegment::parse( Parser& parser )
+{
+  header.parse( parser );
+  parser.all_remaining( payload );
+}
+
+void TCPSegment::serialize( Serializer& serializer ) const
+{
+  header.serialize( serializer );
+  serializer.buffer( payload );
+}
+
+void TCPSegment::compute_checksum( const uint32_t pseudo_checksum )
+{
+  header.doff = header.serialized_length() / 4;
+  header.cksum = 0;
+
+  InternetChecksum check { pseudo_checksum };
+  check.add( ::serialize( header ) );
+  check.add( payload );
+  header.cksum = check.value();
+}
+
+bool TCPSegment::checksum_ok( const uint32_t pseudo_checksum, const vector<Buffer>& segment )
+{
+  InternetChecksum check { pseudo_checksum };
+  check.add( segment );
+  return check.value() == 0;
+}
+
+TCPMessage TCPSegment::to_message() const
+{
+  TCPMessage message;
+  message.sender.seqno = Wrap32 { header.seqno };
+  message.sender.SYN = header.syn;
+  message.sender.FIN = header.fin;
+  if ( payload.size() == 1 ) {
+    message.sender.payload = payload.front();
+  } else {
+    string data;
+    for ( const auto& x : payload ) {
+      data.append( static_cast<string_view>( x ) );
+    }
+    message.sender.payload = std::move( data );
+  }
+
+  if ( header.ack ) {
+    message.receiver.ackno = Wrap32 { header.ackno };
+  }
+  message.receiver.window_size = header.win;
+  return message;
+}
+
+TCPSegment TCPSegment::from_message( const TCPMessage& message, const uint16_t sport, const uint16_t dport )
+{
+  TCPSegment segment;
+  segment.header.sport = sport;
+  segment.header.dport = dport;
+  segment.header.seqno = message.sender.seqno.raw_value();
+  segment.header.syn = message.sender.SYN;
+  segment.header.fin = message.sender.FIN;
+  if ( message.receiver.ackno ) {
+    segment.header.ack = true;
+    segment.header.ackno = message.receiver.ackno->raw_value();
+  }
+  segment.header.win = message.receiver.window_size;
+  if ( not message.sender.payload.empty() ) {
+    segment.payload.push_back( message.sender.payload );
+  }
+  return segment;
+}
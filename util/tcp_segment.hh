@@ -0,0 +1,127 @@
+#pragma once
+
+#include "buffer.hh"
+#include "parser.hh"
+#include "tcp_message.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// One SACK block: the sequence space [left, right) has been received
+struct TCPSACKBlock
+{
+  uint32_t left {};
+  uint32_t right {};
+
+  bool operator==( const TCPSACKBlock& other ) const = default;
+};
+
+// TCP timestamps option
+struct TCPTimestamps
+{
+  uint32_t value {};      // TSval: sender's clock
+  uint32_t echo_reply {}; // TSecr: most recent TSval received from the peer
+
+  bool operator==( const TCPTimestamps& other ) const = default;
+};
+
+// [TCP](\ref rfc::rfc9293) segment header, including the MSS, window scale, SACK and timestamp options
+struct TCPHeader
+{
+  static constexpr size_t LENGTH = 20;             // TCP header length, not including options
+  static constexpr size_t MAX_OPTIONS_LENGTH = 40; // Options can take at most 40 bytes
+  static constexpr size_t MAX_SACK_BLOCKS = 4;     // SACK blocks that fit in the options space
+
+  static constexpr uint8_t OPT_EOL = 0;
+  static constexpr uint8_t OPT_NOP = 1;
+  static constexpr uint8_t OPT_MSS = 2;
+  static constexpr uint8_t OPT_WINDOW_SCALE = 3;
+  static constexpr uint8_t OPT_SACK_PERMITTED = 4;
+  static constexpr uint8_t OPT_SACK = 5;
+  static constexpr uint8_t OPT_TIMESTAMPS = 8;
+
+  /*
+   *   0                   1                   2                   3
+   *   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |          Source Port          |       Destination Port        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                        Sequence Number                        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                    Acknowledgment Number                      |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |  Data |       |U|A|P|R|S|F|                                   |
+   *  | Offset| Rsrvd |R|C|S|S|Y|I|            Window                 |
+   *  |       |       |G|K|H|T|N|N|                                   |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |           Checksum            |         Urgent Pointer        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                    Options                    |    Padding    |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   */
+
+  // TCP Header fields
+  uint16_t sport = 0; // source port
+  uint16_t dport = 0; // destination port
+  uint32_t seqno = 0; // sequence number
+  uint32_t ackno = 0; // acknowledgment number
+  uint8_t doff = 5;   // data offset (header length in multiples of 32 bits)
+  bool urg = false;   // urgent pointer is significant
+  bool ack = false;   // ackno is significant
+  bool psh = false;   // push
+  bool rst = false;   // reset the connection
+  bool syn = false;   // synchronize sequence numbers
+  bool fin = false;   // no more data from sender
+  uint16_t win = 0;   // window size
+  uint16_t cksum = 0; // checksum field
+  uint16_t uptr = 0;  // urgent pointer
+
+  // TCP options (serialized in this order, padded to a multiple of 32 bits)
+  std::optional<uint16_t> mss {};         // maximum segment size (SYN only)
+  std::optional<uint8_t> window_scale {}; // window scale shift count (SYN only)
+  bool sack_permitted = false;            // SACK may be used on this connection (SYN only)
+  std::optional<TCPTimestamps> timestamps {};
+  std::array<TCPSACKBlock, MAX_SACK_BLOCKS> sack {};
+  uint8_t sack_blocks = 0; // number of valid entries in `sack`
+
+  // Length of the options (including padding), in bytes
+  uint64_t options_length() const;
+
+  // Length of the header including options (doff must equal this / 4 when serializing)
+  uint64_t serialized_length() const { return LENGTH + options_length(); }
+
+  // Return a string containing a header in human-readable format
+  std::string to_string() const;
+
+  void parse( Parser& parser );
+  void serialize( Serializer& serializer ) const;
+
+private:
+  void parse_options( Parser& parser, uint64_t length );
+};
+
+// A TCP segment: header plus payload
+struct TCPSegment
+{
+  TCPHeader header {};
+  std::vector<Buffer> payload {};
+
+  void parse( Parser& parser );
+  void serialize( Serializer& serializer ) const;
+
+  // Set header.doff and header.cksum for the segment as currently filled in. `pseudo_checksum`
+  // is the IPv4 pseudo-header's contribution (IPv4Header::pseudo_checksum()).
+  void compute_checksum( uint32_t pseudo_checksum );
+
+  // Does the checksum over a segment's raw bytes (e.g. IPv4Datagram::payload) come out right?
+  // Check this before parsing, since a parsed header need not reserialize to identical bytes.
+  static bool checksum_ok( uint32_t pseudo_checksum, const std::vector<Buffer>& segment );
+
+  // Conversions to and from the in-memory message exchanged by TCPConnection
+  TCPMessage to_message() const;
+  static TCPSegment from_message( const TCPMessage& message, uint16_t sport, uint16_t dport );
+};